@@ -4,15 +4,21 @@
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Double_Window.H>
 #include <FL/fl_draw.H>
+#include <FL/x.H>
 #include <math.h>
 #include <time.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "particles.h"
+#include "swarm.h"
+
 using namespace std;
 
 const int windowWidth = 500;
@@ -21,29 +27,39 @@ const double refreshPerSecond = 60;
 
 /*-- EDIT THE FUNCTIONS HERE AND ADD YOUR OWN */
 
+// Global variables
+int times = 0;           // Incremented every update
+const int boxSize = 20;  // Size of the box we will draw
+
+// The demos are updated a fixed number of times a second, whatever the
+// number of frames drawn, see advance
+const double updatesPerSecond = 60;
+const double updateStep = 1.0 / updatesPerSecond;
+// Longest time a frame catches up on, so that after a pause the demo
+// does not spend seconds in updates
+const double maxFrameTime = 0.25;
+double lag = 0;  // Time not yet updated, less than updateStep
+chrono::steady_clock::time_point lastFrame;
+
 // Init is called once a the beginning of the program
 // Do not draw anything in init
 void init() {
+    lastFrame = chrono::steady_clock::now();
 }
 
-// Global variables
-int times = 0;           // Incremented every draw
-const int boxSize = 20;  // Size of the box we will draw
-
 void draw1() {
     Fl_Color boxColor = fl_rgb_color(100, 200, 100);
     fl_draw_box(Fl_Boxtype::FL_FLAT_BOX,
                 windowWidth / 2,
                 windowHeight / 2, boxSize, boxSize, boxColor);
-    times += 1;
 }
 
-void draw2() {
+// alpha is the part of an update between the last update and the frame
+void draw2(double alpha) {
     Fl_Color boxColor = fl_rgb_color(100, 200, 100);
     fl_draw_box(FL_FLAT_BOX,
-                windowWidth / 2 + 100.0 * sin(times / 50.0),
-                windowHeight / 2 + 100.0 * cos(times / 50.0), boxSize, boxSize, boxColor);
-    times += 1;
+                windowWidth / 2 + 100.0 * sin((times + alpha) / 50.0),
+                windowHeight / 2 + 100.0 * cos((times + alpha) / 50.0), boxSize, boxSize, boxColor);
 }
 
 struct Point {
@@ -58,119 +74,279 @@ void draw3() {
 }
 
 Point boxPos = {0.0, 0.0};  // Need to remember where the box is
+Point previousBoxPos = boxPos;  // Before the last update
+const double chaseRate = 0.6;  // Part of the way to the mouse the box goes in a second
 
-void draw4() {
-    Fl_Color boxColor = fl_rgb_color(100, 200, 100);
-    fl_draw_box(FL_FLAT_BOX, boxPos.x, boxPos.y, boxSize, boxSize, boxColor);
-    boxPos.x -= (boxPos.x - mousePos.x + boxSize / 2) / 100;
-    boxPos.y -= (boxPos.y - mousePos.y + boxSize / 2) / 100;
-    times += 1;
+// Moves the box towards the mouse
+void chase(double dt) {
+    previousBoxPos = boxPos;
+    boxPos.x -= (boxPos.x - mousePos.x + boxSize / 2) * chaseRate * dt;
+    boxPos.y -= (boxPos.y - mousePos.y + boxSize / 2) * chaseRate * dt;
+}
+
+bool caught() {
+    return mousePos.x - boxPos.x < boxSize &&
+           mousePos.x - boxPos.x > 0 &&
+           mousePos.y - boxPos.y < boxSize &&
+           mousePos.y - boxPos.y > 0;
 }
 
-void draw5() {
+void respawn() {
+    boxPos.x = rand() % windowWidth;
+    boxPos.y = rand() % windowHeight;
+    previousBoxPos = boxPos;  // It jumps, it does not move across the window
+}
+
+// The box where it is at the time of the frame, between its positions
+// before and after the last update
+void drawBox(double alpha) {
     Fl_Color boxColor = fl_rgb_color(100, 200, 100);
-    fl_draw_box(FL_FLAT_BOX, boxPos.x, boxPos.y, boxSize, boxSize, boxColor);
-    boxPos.x -= (boxPos.x - mousePos.x + boxSize / 2) / 100;
-    boxPos.y -= (boxPos.y - mousePos.y + boxSize / 2) / 100;
-    times += 1;
-    if (mousePos.x - boxPos.x < boxSize &&
-        mousePos.x - boxPos.x > 0 &&
-        mousePos.y - boxPos.y < boxSize &&
-        mousePos.y - boxPos.y > 0) {
-        boxPos.x = rand() % windowWidth;
-        boxPos.y = rand() % windowHeight;
-    }
+    fl_draw_box(FL_FLAT_BOX,
+                previousBoxPos.x + (boxPos.x - previousBoxPos.x) * alpha,
+                previousBoxPos.y + (boxPos.y - previousBoxPos.y) * alpha,
+                boxSize, boxSize, boxColor);
+}
+
+void draw4(double alpha) {
+    drawBox(alpha);
+}
+
+void draw5(double alpha) {
+    drawBox(alpha);
 }
 
 vector<Point> craters;  // Need to store the craters
 
-void draw6() {
+// The craters are drawn once, in an offscreen layer the size of the
+// window, which is copied to the window every frame. So a frame takes
+// the same time however many craters there are. The layer is only
+// drawn again from craters when the window changes size, or after they
+// are cleared.
+Fl_Offscreen craterLayer = 0;
+int craterLayerWidth = 0, craterLayerHeight = 0;
+size_t cratersInLayer = 0;
+bool craterLayerCleared = false;
+
+void drawCrater(Point crater) {
     Fl_Color craterColor = fl_rgb_color(200, 100, 100);
-    for (auto crater : craters) {
-        fl_draw_box(FL_FLAT_BOX, crater.x, crater.y, boxSize, boxSize, craterColor);
+    fl_draw_box(FL_FLAT_BOX, crater.x, crater.y, boxSize, boxSize, craterColor);
+}
+
+// Copies the craters to the window, after adding those made by the
+// updates since the last frame to the layer, or making it again if
+// needed
+void drawCraters() {
+    Fl_Window *window = Fl_Window::current();
+    if (!craterLayer || craterLayerCleared ||
+        craterLayerWidth != window->w() || craterLayerHeight != window->h()) {
+        if (craterLayer) fl_delete_offscreen(craterLayer);
+        craterLayerWidth = window->w();
+        craterLayerHeight = window->h();
+        craterLayer = fl_create_offscreen(craterLayerWidth, craterLayerHeight);
+        cratersInLayer = 0;
+        craterLayerCleared = false;
+        fl_begin_offscreen(craterLayer);
+        fl_rectf(0, 0, craterLayerWidth, craterLayerHeight, FL_BACKGROUND_COLOR);
+        fl_end_offscreen();
     }
-    Fl_Color boxColor = fl_rgb_color(100, 200, 100);
-    fl_draw_box(FL_FLAT_BOX, boxPos.x, boxPos.y, boxSize, boxSize, boxColor);
-    boxPos.x -= (boxPos.x - mousePos.x + boxSize / 2) / 100;
-    boxPos.y -= (boxPos.y - mousePos.y + boxSize / 2) / 100;
-    times += 1;
-    if (mousePos.x - boxPos.x < boxSize &&
-        mousePos.x - boxPos.x > 0 &&
-        mousePos.y - boxPos.y < boxSize &&
-        mousePos.y - boxPos.y > 0) {
-        craters.push_back(boxPos);
-        boxPos.x = rand() % windowWidth;
-        boxPos.y = rand() % windowHeight;
+    if (cratersInLayer < craters.size()) {
+        fl_begin_offscreen(craterLayer);
+        for (; cratersInLayer < craters.size(); cratersInLayer++) drawCrater(craters[cratersInLayer]);
+        fl_end_offscreen();
     }
+    fl_copy_offscreen(0, 0, craterLayerWidth, craterLayerHeight, craterLayer, 0, 0);
 }
 
-int explode = 0;   // Status of the explosion 0=over, 20=just started
-Point explodePos;  // Location of the explosion
+void clearCraters() {
+    craters.clear();
+    craterLayerCleared = true;
+}
 
-void draw8() {
-    Fl_Color explodeColor = fl_rgb_color(250, 200, 200);
-    if (explode) {
-        int explodeRad = 5 * (20 - explode);
-        fl_draw_box(FL_FLAT_BOX,
-                    explodePos.x - explodeRad,
-                    explodePos.y - explodeRad,
-                    2 * explodeRad,
-                    2 * explodeRad, explodeColor);
-        explode--;
-    }
-    Fl_Color craterColor = fl_rgb_color(200, 100, 100);
-    for (auto crater : craters) {
-        fl_draw_box(FL_FLAT_BOX, crater.x, crater.y, boxSize, boxSize, craterColor);
+void draw6(double alpha) {
+    drawCraters();
+    drawBox(alpha);
+}
+
+// The explosions, a burst of particles each
+const int particlesPerExplosion = 25000;
+ParticleSystem particles(8 * particlesPerExplosion);
+
+// All the particles in one batch of points of the same color, where
+// they are at the time of the frame
+void drawParticles(double alpha) {
+    const float *x = particles.getX(), *y = particles.getY();
+    const float *vx = particles.getVX(), *vy = particles.getVY();
+    const float ahead = alpha * updateStep;
+    fl_color(fl_rgb_color(250, 200, 200));
+    fl_begin_points();
+    for (size_t i = 0; i < particles.size(); i++)
+        fl_vertex(x[i] + vx[i] * ahead, y[i] + vy[i] * ahead);
+    fl_end_points();
+}
+
+void draw8(double alpha) {
+    // The layer covers the whole window, so the explosions are drawn on
+    // top of the craters
+    drawCraters();
+    drawParticles(alpha);
+    drawBox(alpha);
+}
+
+// Demo 9: a swarm of up to a million boxes chasing the mouse, to
+// compare ways of updating them. + and - change the number of boxes, t
+// switches between one thread and all of them. Each box is drawn as the
+// pixel at its center, all of them in one image.
+ChaserSwarm swarm;
+size_t swarmSize = 100000;
+const size_t maxSwarmSize = 1000000;
+int swarmThreads = 1;
+double swarmUpdateSeconds = 0;  // Time taken by the last update
+size_t swarmCaught = 0;         // Boxes that caught the mouse in the last update
+double frameSeconds = 0;        // Time from the frame before to the last one
+vector<uchar> swarmPixels;
+
+void draw9() {
+    Fl_Window *window = Fl_Window::current();
+    const int w = window->w(), h = window->h();
+    swarmPixels.assign(size_t(w) * h * 3, 255);
+    const float *x = swarm.getX(), *y = swarm.getY();
+    for (size_t i = 0; i < swarm.size(); i++) {
+        const int px = x[i] + boxSize / 2, py = y[i] + boxSize / 2;
+        if (px < 0 || px >= w || py < 0 || py >= h) continue;
+        uchar *pixel = &swarmPixels[(size_t(py) * w + px) * 3];
+        pixel[0] = 100;
+        pixel[1] = 200;
+        pixel[2] = 100;
     }
-    Fl_Color boxColor = fl_rgb_color(100, 200, 100);
-    fl_draw_box(FL_FLAT_BOX, boxPos.x, boxPos.y, boxSize, boxSize, boxColor);
-    boxPos.x -= (boxPos.x - mousePos.x + boxSize / 2) / 100;
-    boxPos.y -= (boxPos.y - mousePos.y + boxSize / 2) / 100;
+    fl_draw_image(swarmPixels.data(), 0, 0, w, h);
+
+    char text[200];
+    snprintf(text, sizeof(text), "%zu chasers, %d thread%s: update %.2f ms, %.0f million chasers/s",
+             swarm.size(), swarmThreads, swarmThreads > 1 ? "s" : "", swarmUpdateSeconds * 1000,
+             swarm.size() / max(swarmUpdateSeconds, 1e-9) / 1e6);
+    fl_color(FL_BLACK);
+    fl_font(FL_HELVETICA, 14);
+    fl_draw(text, 10, 20);
+    snprintf(text, sizeof(text), "frame %.1f ms, %zu caught", frameSeconds * 1000, swarmCaught);
+    fl_draw(text, 10, 40);
+}
+
+char whichDemo = '1';  // Remembers which demo is currently running
+
+void startDemo(char demo) {
+    whichDemo = demo;
+    if (demo == '9') swarm.reset(swarmSize, windowWidth, windowHeight);
+}
+
+// Moves the demo that is running dt seconds forward. It does not draw
+// anything, and is always called with updateStep: times counts
+// updates.
+void update(double dt) {
     times += 1;
-    if (mousePos.x - boxPos.x < boxSize &&
-        mousePos.x - boxPos.x > 0 &&
-        mousePos.y - boxPos.y < boxSize &&
-        mousePos.y - boxPos.y > 0) {
-        explodePos = boxPos;
-        explode = 20;
-        craters.push_back(boxPos);
-        boxPos.x = rand() % windowWidth;
-        boxPos.y = rand() % windowHeight;
+    switch (whichDemo) {
+        case '4':
+            chase(dt);
+            break;
+        case '5':
+            chase(dt);
+            if (caught()) respawn();
+            break;
+        case '6':
+        case '7':
+            chase(dt);
+            if (caught()) {
+                craters.push_back(boxPos);
+                respawn();
+            }
+            break;
+        case '8':
+            particles.update(dt);
+            chase(dt);
+            if (caught()) {
+                particles.burst(boxPos.x + boxSize / 2, boxPos.y + boxSize / 2,
+                                particlesPerExplosion, 150, 1.5);
+                craters.push_back(boxPos);
+                respawn();
+            }
+            break;
+        case '9': {
+            const auto start = chrono::steady_clock::now();
+            swarmCaught = swarm.update(mousePos.x, mousePos.y, chaseRate * dt,
+                                       windowWidth, windowHeight, swarmThreads);
+            swarmUpdateSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            break;
+        }
     }
 }
 
-char whichDemo = '1';  // Remembers which demo is currently running
+// Runs the updates due after frameTime more seconds, and returns the
+// part of an update between the last one and now, to draw the frame.
+// So the demos go at the same speed however often frames are drawn,
+// and slow frames are caught up on.
+double advance(double frameTime) {
+    lag += min(frameTime, maxFrameTime);
+    // The frame times add up with rounding errors, an update a nanosecond
+    // early is better than one a frame late
+    while (lag >= updateStep - 1e-9) {
+        update(updateStep);
+        lag -= updateStep;
+    }
+    return max(0.0, lag / updateStep);
+}
 
-// Draw is called 60 times a second.
-// You should draw what the use should see here
+// Draw is called 60 times a second, or less often if the computer is
+// busy. You should draw what the use should see here
 // Every time it starts with a blank screen
 void draw() {
+    const auto now = chrono::steady_clock::now();
+    frameSeconds = chrono::duration<double>(now - lastFrame).count();
+    const double alpha = advance(frameSeconds);
+    lastFrame = now;
     switch (whichDemo) {
         case '1':
             draw1();
             break;
         case '2':
-            draw2();
+            draw2(alpha);
             break;
         case '3':
             draw3();
             break;
         case '4':
-            draw4();
+            draw4(alpha);
             break;
         case '5':
-            draw5();
+            draw5(alpha);
             break;
         case '6':
         case '7':
-            draw6();
+            draw6(alpha);
             break;
         case '8':
-            draw8();
+            draw8(alpha);
+            break;
+        case '9':
+            draw9();
             break;
     }
 }
 
+// Runs a demo without any window, with the mouse in the middle, for
+// seconds at framesPerSecond, then prints where it is. The same demo
+// ends the same at any number of frames per second.
+void runHeadless(char demo, double seconds, double framesPerSecond) {
+    startDemo(demo);
+    mousePos = {windowWidth / 2, windowHeight / 2};
+    for (int frame = 0; frame < seconds * framesPerSecond; frame++)
+        advance(1 / framesPerSecond);
+    cout << "demo " << demo << " at " << framesPerSecond << " frames per second: "
+         << times << " updates, box at " << boxPos.x << ", " << boxPos.y << ", "
+         << craters.size() << " craters, " << particles.size() << " particles" << endl;
+    if (demo == '9')
+        cout << swarm.size() << " chasers, last update in " << swarmUpdateSeconds * 1000 << " ms, "
+             << swarm.size() / swarmUpdateSeconds / 1e6 << " million chasers per second" << endl;
+}
+
 // mouseMove is called every time the mouse moves
 // It is called with the current mouse position
 void mouseMove(int x, int y) {
@@ -186,7 +362,7 @@ void mouseMove(int x, int y) {
 void keyPressed(int keyCode) {
     switch (keyCode) {
         case ' ':
-            if (whichDemo >= '7') craters.clear();
+            if (whichDemo >= '7') clearCraters();
             break;
         case '1':
         case '2':
@@ -196,14 +372,26 @@ void keyPressed(int keyCode) {
         case '6':
         case '7':
         case '8':
-            whichDemo = keyCode;
+        case '9':
+            startDemo(keyCode);
+            break;
+        case '+':
+        case '=':
+        case '-':
+            if (whichDemo != '9') exit(0);
+            swarmSize = keyCode == '-' ? max<size_t>(1000, swarmSize / 10) : min(maxSwarmSize, swarmSize * 10);
+            startDemo('9');
+            break;
+        case 't':
+            if (whichDemo != '9') exit(0);
+            swarmThreads = swarmThreads > 1 ? 1 : max(1u, thread::hardware_concurrency());
             break;
         default:
             exit(0);
     }
 }
 
-/* ------ DO NOT EDIT BELOW HERE (FOR NOW) ------ */
+/* ------ THE WINDOW, AND main WITH ITS HEADLESS MODE ------ */
 class MainWindow : public Fl_Window {
    public:
     MainWindow() : Fl_Window(000, 000, windowWidth, windowHeight, "Lab 1") {
@@ -231,8 +419,16 @@ class MainWindow : public Fl_Window {
     }
 };
 
+// lab1sol [headless demo seconds framesPerSecond [threads chasers]]
 int main(int argc, char *argv[]) {
     init();
+    if (argc > 1 && string(argv[1]) == "headless") {
+        if (argc > 5) swarmThreads = max(1, atoi(argv[5]));
+        if (argc > 6) swarmSize = min<size_t>(maxSwarmSize, atol(argv[6]));
+        runHeadless(argc > 2 ? argv[2][0] : '8', argc > 3 ? atof(argv[3]) : 60,
+                    argc > 4 ? atof(argv[4]) : 60);
+        return 0;
+    }
     MainWindow window;
     window.show(argc, argv);
     return Fl::run();
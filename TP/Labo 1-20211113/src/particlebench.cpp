@@ -0,0 +1,44 @@
+// Benchmark of ParticleSystem::update.
+//
+// Keeps about the given number of particles alive, with a burst every
+// update to replace those that die, and prints how many particles were
+// updated per millisecond.
+//
+// It does not need FLTK.
+//
+// Usage: particlebench [particles] [updates]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "particles.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    const size_t particles = argc > 1 ? atol(argv[1]) : 200000;
+    const int updates = argc > 2 ? atoi(argv[2]) : 2000;
+    const float dt = 1 / 60.0;
+    const float maxLife = 1;
+
+    ParticleSystem system(particles);
+    // On average a particle lives 3/4 of maxLife, so this many die in
+    // every update once the system is full
+    const size_t perUpdate = particles * dt / (0.75 * maxLife);
+    system.burst(250, 250, particles, 300, maxLife);
+
+    size_t updated = 0;
+    double seconds = 0;
+    for (int i = 0; i < updates; i++) {
+        system.burst(250, 250, perUpdate, 300, maxLife);
+        updated += system.size();
+        const auto start = chrono::steady_clock::now();
+        system.update(dt);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    cout << fixed << setprecision(0) << updated / updates << " particles alive on average, "
+         << setprecision(3) << seconds * 1000 / updates << " ms per update, "
+         << setprecision(0) << updated / (seconds * 1000) << " particles updated per ms" << endl;
+    return 0;
+}
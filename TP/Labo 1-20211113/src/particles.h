@@ -0,0 +1,106 @@
+#ifndef __PARTICLES_H
+#define __PARTICLES_H
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/*--------------------------------------------------
+
+ParticleSystem class.
+
+Particles thrown by bursts, which fly and fall until
+their lifetime is over. The particles are not
+objects: each of their properties is in its own
+array, so that update goes through plain arrays of
+floats with the same operations on each element,
+which the compiler turns into SIMD instructions.
+
+All the arrays are made once, as big as the most
+particles alive at once. A dead particle is replaced
+by the last one alive (swap and pop), so nothing is
+allocated or moved after the constructor, and the
+particles alive are always the first size() ones.
+
+--------------------------------------------------*/
+
+class ParticleSystem {
+    size_t capacity;
+    size_t count = 0;  // Particles alive
+    vector<float> x, y, vx, vy, life;  // Position, velocity, seconds left
+    mt19937 random{0};
+
+   public:
+    float gravity = 200;  // Pixels per second per second, downwards
+
+    ParticleSystem(size_t capacity) : capacity{capacity},
+                                      x(capacity), y(capacity), vx(capacity), vy(capacity), life(capacity) {}
+
+    // Throws particles all around x, y, with speeds up to maxSpeed pixels
+    // per second, living up to maxLife seconds. Particles that do not fit
+    // are not thrown.
+    void burst(float centerX, float centerY, size_t particles, float maxSpeed, float maxLife) {
+        uniform_real_distribution<float> angle(0, 2 * M_PI), unit(0, 1);
+        for (size_t end = min(capacity, count + particles); count < end; count++) {
+            const float a = angle(random), speed = maxSpeed * sqrt(unit(random));
+            x[count] = centerX;
+            y[count] = centerY;
+            vx[count] = speed * cos(a);
+            vy[count] = speed * sin(a);
+            life[count] = maxLife * (0.5f + 0.5f * unit(random));
+        }
+    }
+
+    // Moves the particles dt seconds forward, and removes those that died
+    void update(float dt) {
+        float *__restrict px = x.data();
+        float *__restrict py = y.data();
+        float *__restrict pvx = vx.data();
+        float *__restrict pvy = vy.data();
+        float *__restrict plife = life.data();
+        const float fall = gravity * dt;
+        for (size_t i = 0; i < count; i++) {
+            px[i] += pvx[i] * dt;
+            py[i] += pvy[i] * dt;
+            pvy[i] += fall;
+            plife[i] -= dt;
+        }
+        for (size_t i = 0; i < count;) {
+            if (plife[i] > 0) {
+                i++;
+                continue;
+            }
+            count--;
+            px[i] = px[count];
+            py[i] = py[count];
+            pvx[i] = pvx[count];
+            pvy[i] = pvy[count];
+            plife[i] = plife[count];
+        }
+    }
+
+    void clear() {
+        count = 0;
+    }
+    size_t size() const {
+        return count;
+    }
+    // The first size() elements are the particles alive
+    const float *getX() const {
+        return x.data();
+    }
+    const float *getY() const {
+        return y.data();
+    }
+    const float *getVX() const {
+        return vx.data();
+    }
+    const float *getVY() const {
+        return vy.data();
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef __SWARM_H
+#define __SWARM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "threadpool.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+
+ChaserSwarm class.
+
+Many boxes chasing the mouse, like the box of the
+demos 4 to 8: every update, each one goes a part of
+the way to the mouse, and when the mouse is in it,
+it is caught and jumps somewhere else.
+
+Their positions are two arrays of floats, x and y,
+and one loop moves the boxes, tests whether the
+mouse is in them and makes those that are jump,
+without any branch: the new place of a box is a
+hash of its index and of the update, computed for
+every box and only kept for those caught. So the
+compiler makes SIMD instructions of all of it.
+
+update can also split the boxes in chunks, each
+updated by its own thread of a ThreadPool, made once
+and kept until the number of threads changes. The
+chunks are a multiple of 16 boxes, so that no two
+threads write to the same cache line.
+
+--------------------------------------------------*/
+
+class ChaserSwarm {
+    vector<float> x, y;
+    uint32_t updates = 0;
+    unique_ptr<ThreadPool> pool;
+
+    static uint32_t hash(uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x7FEB352D;
+        h ^= h >> 15;
+        h *= 0x846CA68B;
+        return h ^ (h >> 16);
+    }
+    // Updates the boxes first to last-1, returns how many were caught
+    size_t updateRange(size_t first, size_t last, float mouseX, float mouseY, float step,
+                       float width, float height) {
+        float *__restrict px = x.data();
+        float *__restrict py = y.data();
+        const float scaleX = width / 65536, scaleY = height / 65536;
+        const uint32_t seed = hash(updates);
+        const float size = boxSize, half = boxSize / 2;
+        int caught = 0;
+        for (size_t i = first; i < last; i++) {
+            const float nx = px[i] - (px[i] - mouseX + half) * step;
+            const float ny = py[i] - (py[i] - mouseY + half) * step;
+            const float dx = mouseX - nx, dy = mouseY - ny;
+            // 1 if the mouse is in the box, as a float, which GCC turns
+            // into SIMD instructions where a bool or a select is not
+            const float hit = (dx > 0) & (dx < size) & (dy > 0) & (dy < size) ? 1.f : 0.f;
+            const uint32_t h = hash(uint32_t(i) ^ seed);
+            const float jumpX = float(int(h & 0xFFFF)) * scaleX, jumpY = float(int(h >> 16)) * scaleY;
+            px[i] = nx + (jumpX - nx) * hit;
+            py[i] = ny + (jumpY - ny) * hit;
+            caught += int(hit);
+        }
+        return caught;
+    }
+
+   public:
+    float boxSize = 20;
+
+    // count boxes anywhere in a width x height window
+    void reset(size_t count, float width, float height) {
+        x.resize(count);
+        y.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t h = hash(uint32_t(i) ^ 0x9E3779B9);
+            x[i] = float(h & 0xFFFF) * (width / 65536);
+            y[i] = float(h >> 16) * (height / 65536);
+        }
+    }
+
+    // Moves every box step of the way to the mouse, and makes those that
+    // caught it jump somewhere in the window, on threads threads. Returns
+    // how many were caught.
+    size_t update(float mouseX, float mouseY, float step, float width, float height, int threads = 1) {
+        updates += 1;
+        const size_t count = x.size();
+        threads = max(1, min<int>(threads, count / 4096));
+        if (threads == 1) return updateRange(0, count, mouseX, mouseY, step, width, height);
+        if (!pool || pool->size() != threads) pool = make_unique<ThreadPool>(threads);
+        const size_t chunk = ((count + threads - 1) / threads + 15) / 16 * 16;
+        vector<size_t> caught(threads);
+        pool->forEach(threads, [&](size_t t, int) {
+            caught[t] = updateRange(min(count, t * chunk), min(count, (t + 1) * chunk),
+                                    mouseX, mouseY, step, width, height);
+        });
+        size_t total = 0;
+        for (size_t c : caught) total += c;
+        return total;
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+    const float *getX() const {
+        return x.data();
+    }
+    const float *getY() const {
+        return y.data();
+    }
+};
+
+#endif
@@ -0,0 +1,57 @@
+// Scaling benchmark of the parallel Solver.
+//
+// Solves a fixed set of positions with 1, 2, 4 and 8 threads, starting
+// from an empty transposition table every time, and prints the total
+// time to solve them and the number of nodes searched per second.
+//
+// Usage: bench.out [max threads]
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "solver.h"
+
+using namespace std;
+
+// Positions given as the columns played from the start (1 to 7), each
+// taking between a tenth of a second and a second on one thread
+const vector<string> positions = {
+  "32121415264112",
+  "67722572444732",
+  "37766537124675",
+  "71731123213613",
+  "6546755143244245",
+  "2767777622755623",
+};
+
+int main(int argc, char *argv[]) {
+  int maxThreads = argc>1?atoi(argv[1]): 8;
+  Solver<Connect4> solver;
+  cout << "threads      time     nodes      kN/s  speedup" << endl;
+  double oneThread = 0;
+  for (int threads=1; threads<=maxThreads; threads*=2) {
+    solver.setThreads(threads);
+    double seconds = 0;
+    uint64_t nodes = 0;
+    for (const string &position: positions) {
+      Connect4 board;
+      for (char c: position) board.move(c-'1');
+      solver.clear();
+      Solver<Connect4>::Result result = solver.bestMove(board);
+      if (!result.solved) cerr << position << " not solved" << endl;
+      seconds += result.seconds;
+      nodes += result.nodes;
+    }
+    if (threads==1) oneThread = seconds;
+    cout << setw(7) << threads
+         << fixed << setprecision(3) << setw(9) << seconds << "s"
+         << setw(10) << nodes
+         << setprecision(0) << setw(10) << nodes/seconds/1000
+         << setprecision(2) << setw(8) << oneThread/seconds << "x"
+         << defaultfloat << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,473 @@
+#ifndef __BOARD_H
+#define __BOARD_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+using namespace std;
+
+/*--------------------------------------------------
+ArrayBoard class.
+
+The original board: one square per array cell and a
+full scan of the board after every move. It is slow
+but easy to check by hand, so it is kept as the
+reference implementation the bitboard Board below
+is compared against by crosscheck.cpp.
+--------------------------------------------------*/
+
+template <int Rows, int Columns, int ToWin>
+class ArrayBoard {
+ public:
+  static const int rows = Rows;
+  static const int columns = Columns;
+  static const int toWin = ToWin;
+  enum squareType {Empty, Red, Black};
+  enum gameState {RedTurn, BlackTurn, RedWins, BlackWins, Tie};
+ private:
+  gameState currentGameState = RedTurn;
+  bool blackWentFirst = true;
+  array< array< squareType, columns >, rows > board;
+ public:
+  ArrayBoard() {
+    newGame();
+  }
+  squareType getSquare(int row, int column) const {
+    return board.at(row).at(column);
+  }
+  gameState getGameState() const {
+    return currentGameState;
+  }
+  bool move (int column) { // Returns True if it was a valid move
+    if (currentGameState==RedWins
+        || currentGameState == BlackWins
+        || currentGameState == Tie)
+      return false; // Can not move
+    // Finds where the piece should go
+    int row = 0;
+    while (row <rows && getSquare(row, column) == Empty) row+=1;
+    if (row==0) return false; // Row full
+    board.at(row-1).at(column)=currentGameState==RedTurn?Red: Black; //make move
+
+    //This code checks to see if there are four in a row
+    //Starting in every square and going in four different directions
+    //(Horizonal, vertical, two diagonals)
+    int x;
+    for (int row=0; row<rows; row++)
+      for (int column=0; column<columns; column++)
+        if (getSquare(row, column)!=Empty) {
+          squareType color = getSquare(row, column);
+
+          for (x=1; x<toWin; x++)
+            if (row+x>=rows || getSquare(row+x, column)!=color) break;
+          if (x==toWin) {
+            currentGameState=(color==Red)?RedWins: BlackWins;
+            return true;
+          }
+          for (x=1; x<toWin; x++)
+            if (column+x>=columns || getSquare(row, column+x)!=color) break;
+          if (x==toWin) {
+            currentGameState=(color==Red)?RedWins: BlackWins;
+            return true;
+          }
+          for (x=1; x<toWin; x++)
+            if (row+x>=rows || column+x>=columns || getSquare(row+x, column+x)!=color) break;
+          if (x==toWin) {
+            currentGameState=(color==Red)?RedWins: BlackWins;
+            return true;
+          }
+          for (x=1; x<toWin; x++)
+            if (row+x>=rows || column-x<0 || getSquare(row+x, column-x)!=color) break;
+          if (x==toWin) {
+            currentGameState=(color==Red)?RedWins: BlackWins;
+            return true;
+          }
+        }
+    // This checks for a tie (all top squares are occupoed)
+    for (x=0; x<columns; x++) if (getSquare(0, x)==Empty) break;
+    if (x==columns) {
+      currentGameState = Tie;
+      return true;
+    }
+    // Change whose turn it is
+    currentGameState = currentGameState==RedTurn?BlackTurn: RedTurn;
+    return true;
+  }
+  void newGame() {
+    for (auto &c: board) for (auto &x: c) x = Empty;
+    blackWentFirst=!blackWentFirst;
+    currentGameState = blackWentFirst?BlackTurn: RedTurn;
+  }
+};
+
+/*--------------------------------------------------
+Bitboard storage.
+
+The smallest type holding one bit per square of a
+board, plus one spare bit per column (see Board):
+a 64-bit or a 128-bit integer, or a packed array of
+64-bit words for bigger boards. The helpers below
+give the three the same interface.
+--------------------------------------------------*/
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+template <int Bits>
+using bitboardType = conditional_t < Bits <= 64, uint64_t,
+                     conditional_t < Bits <= 128, uint128_t, bitset<Bits> >>;
+
+inline bool hasBits(uint64_t mask) {
+  return mask != 0;
+}
+inline bool hasBits(uint128_t mask) {
+  return mask != 0;
+}
+template <size_t Bits>
+bool hasBits(const bitset<Bits> &mask) {
+  return mask.any();
+}
+inline int bitCount(uint64_t mask) {
+  return __builtin_popcountll(mask);
+}
+inline int bitCount(uint128_t mask) {
+  return __builtin_popcountll(uint64_t(mask)) + __builtin_popcountll(uint64_t(mask >> 64));
+}
+template <size_t Bits>
+int bitCount(const bitset<Bits> &mask) {
+  return mask.count();
+}
+
+/*--------------------------------------------------
+Board class.
+
+Same interface as ArrayBoard but stored as two
+bitboards, one bit mask per colour, plus the height
+of every column. The size of the board and the
+length of a winning line are template parameters,
+so all the loops below have a fixed number of turns
+known at compile time, and the bitboard type is
+chosen from the size (see bitboardType).
+
+Each column uses rows+1 bits, starting from the
+bottom square. The extra bit on top of each column
+is always zero, so shifting a mask never carries a
+line from one column into the next. On the usual
+6x7 board:
+
+  6 13 20 27 34 41 48
+  5 12 19 26 33 40 47
+  4 11 18 25 32 39 46
+  ...
+  0  7 14 21 28 35 42
+
+move only has to look at the lines going through the
+piece it just dropped: it walks away from it in both
+senses of each direction, 1 bit at a time (vertical),
+rows+1 (horizontal), rows and rows+2 (diagonals),
+and stops at the first square that is not of the
+same colour. It also keeps
+count of the full columns, so a tie is detected
+without looking at the top row again.
+
+Every move is written in a fixed-size history as
+the column played and the state of the game before
+it, which is all unmove needs to take it back. The
+moves taken back stay after the end of the history
+until a different move is played, so redo can play
+them again. Both are O(1) and never allocate, so a
+search can play and take back moves on one board
+instead of copying it at every node.
+--------------------------------------------------*/
+
+template <int Rows, int Columns, int ToWin>
+class Board {
+ public:
+  static const int rows = Rows;
+  static const int columns = Columns;
+  static const int toWin = ToWin;
+  static const int bits = columns*(rows+1);
+  enum squareType {Empty, Red, Black};
+  enum gameState {RedTurn, BlackTurn, RedWins, BlackWins, Tie};
+  typedef bitboardType<bits> bitboard;
+  static const bool packed = bits > 128; // Stored in a bitset
+  static_assert(columns <= 32, "Columns must fit in the bits of an unsigned");
+ private:
+  gameState currentGameState = RedTurn;
+  bool blackWentFirst = true;
+  bitboard red{0}, black{0};
+  array<int, columns> height;
+  int fullColumns = 0;
+  int moves = 0;
+  struct Played {
+    uint8_t column;
+    uint8_t previousState;
+  };
+  array<Played, rows*columns> history;
+  int lastMove = 0; // End of the moves that can be redone
+
+  static bitboard bit(int index) {
+    return bitboard{1} << index;
+  }
+  static bitboard bit(int row, int column) {
+    return bit(column*(rows+1) + rows-1-row);
+  }
+  // Number of pieces of mask next to index, going step bits at a time.
+  // The bits outside of the board are always zero so the walk stops there.
+  static int countFrom(const bitboard &mask, int index, int step) {
+    int x;
+    for (x=1; x<toWin; x++) {
+      int i = index+x*step;
+      if (i<0 || i>=bits || !hasBits(mask & bit(i))) break;
+    }
+    return x-1;
+  }
+  // The squares of the first n rows from the bottom, in every column.
+  // Computed at compile time for integer bitboards, once for bitsets.
+  static constexpr bitboard integerMask(int n) {
+    bitboard mask = 0;
+    for (int column=0; column<columns; column++)
+      mask |= ((bitboard{1} << n)-1) << column*(rows+1);
+    return mask;
+  }
+  static bitboard packedMask(int n) {
+    bitboard mask{0};
+    for (int column=0; column<columns; column++)
+      for (int row=0; row<n; row++) mask |= bit(column*(rows+1)+row);
+    return mask;
+  }
+  static bitboard boardMask() {
+    if constexpr (!packed) {
+      constexpr bitboard mask = integerMask(rows);
+      return mask;
+    } else {
+      static const bitboard mask = packedMask(rows);
+      return mask;
+    }
+  }
+  static bitboard bottomMask() {
+    if constexpr (!packed) {
+      constexpr bitboard mask = integerMask(1);
+      return mask;
+    } else {
+      static const bitboard mask = packedMask(1);
+      return mask;
+    }
+  }
+  static bitboard columnMask(int column) {
+    const bitboard firstColumn = boardMask() & ~(boardMask() << (rows+1));
+    return firstColumn << column*(rows+1);
+  }
+  const bitboard &mine() const {
+    return currentGameState==RedTurn?red: black;
+  }
+  const bitboard &theirs() const {
+    return currentGameState==RedTurn?black: red;
+  }
+  // Next free square of every column that is not full. Adding the
+  // bottom square to a column of pieces carries into the square above
+  // them, bitsets can not add so they look at the heights instead.
+  bitboard playable() const {
+    if constexpr (!packed) {
+      return ((red|black) + bottomMask()) & boardMask();
+    } else {
+      bitboard result{0};
+      for (int column=0; column<columns; column++)
+        if (height[column]<rows) result |= bit(column*(rows+1)+height[column]);
+      return result;
+    }
+  }
+  static bitboard shifted(const bitboard &mask, int shift) {
+    return shift>0?mask >> shift: mask << -shift;
+  }
+  // Empty squares that would complete a line of toWin pieces of mask.
+  // For every direction and every place of the missing square in the
+  // line, the other squares of the line are and-ed together.
+  bitboard winningSquares(const bitboard &mask) const {
+    bitboard result{0};
+    for (int step: {1, rows+1, rows, rows+2})
+      for (int missing=0; missing<toWin; missing++) {
+        bitboard line = boardMask();
+        for (int x=0; x<toWin; x++)
+          if (x!=missing) line &= shifted(mask, (x-missing)*step);
+        result |= line;
+      }
+    return result & ~(red|black);
+  }
+  // The columns of mask in the opposite order
+  static bitboard mirrored(const bitboard &mask) {
+    bitboard result{0};
+    for (int column=0; column<columns; column++)
+      result |= shifted(mask & columnMask(column), (2*column-columns+1)*(rows+1));
+    return result;
+  }
+  // See hash
+  static uint64_t key(const bitboard &mine, const bitboard &occupied) {
+    if constexpr (is_same<bitboard, uint64_t>::value) {
+      return mine + occupied;
+    } else if constexpr (is_same<bitboard, uint128_t>::value) {
+      const uint128_t key = mine + occupied;
+      return uint64_t(key) ^ uint64_t(key >> 64)*0x9E3779B97F4A7C15ull;
+    } else {
+      return std::hash<bitboard>()(mine)*0x9E3779B97F4A7C15ull
+             ^ std::hash<bitboard>()(occupied);
+    }
+  }
+  // Is the piece at index part of a line of toWin pieces of mask?
+  static bool winsThrough(const bitboard &mask, int index) {
+    for (int step: {1, rows+1, rows, rows+2}) {
+      int count = 1+countFrom(mask, index, step);
+      if (count<toWin) count += countFrom(mask, index, -step);
+      if (count>=toWin) return true;
+    }
+    return false;
+  }
+ public:
+  Board() {
+    newGame();
+  }
+  squareType getSquare(int row, int column) const {
+    if (hasBits(red & bit(row, column))) return Red;
+    if (hasBits(black & bit(row, column))) return Black;
+    return Empty;
+  }
+  gameState getGameState() const {
+    return currentGameState;
+  }
+
+  // Queries used by the AI to look at a position without playing it.
+  int moveCount() const {
+    return moves;
+  }
+  bool canPlay(int column) const {
+    return (currentGameState==RedTurn || currentGameState==BlackTurn)
+           && height[column]<rows;
+  }
+  // Does playing column win the game for the player whose turn it is?
+  bool isWinningMove(int column) const {
+    return winsThrough(mine(), column*(rows+1)+height[column]);
+  }
+  // Can the player to move win right now?
+  bool canWinNext() const {
+    return hasBits(winningSquares(mine()) & playable());
+  }
+  // Columns, as bits of the result, where the player to move can play
+  // without letting the other player win on the next move. Zero if
+  // every move loses.
+  unsigned nonLosingColumns() const {
+    const bitboard theirWins = winningSquares(theirs());
+    bitboard moves = playable();
+    const bitboard forced = moves & theirWins;
+    if (hasBits(forced)) {
+      if (bitCount(forced)>1) return 0; // Two threats, can not block both
+      moves = forced;
+    }
+    moves &= ~(theirWins >> 1); // Do not play right under their win
+    unsigned result = 0;
+    for (int column=0; column<columns; column++)
+      if (hasBits(moves & columnMask(column))) result |= 1u << column;
+    return result;
+  }
+  // Number of squares where the player to move would then have a
+  // winning move, if they played column. Used to try good moves first.
+  int threatsAfter(int column) const {
+    const bitboard played = bit(column*(rows+1)+height[column]);
+    return bitCount(winningSquares(mine() | played) & ~played);
+  }
+  // Identifies the position: the pieces of the player to move plus
+  // the occupied squares. On boards of 64 bits or less, their sum is
+  // the key, which is unique thanks to the empty bit on top of every
+  // column. Bigger boards are hashed down to 64 bits. The colours are
+  // not part of the key, only whose turn it is.
+  uint64_t hash() const {
+    return key(mine(), red|black);
+  }
+  // hash of the same position seen in a mirror, with the columns in the
+  // opposite order. Both positions have the same score, and the best
+  // move of one is the mirror image of the best move of the other.
+  uint64_t mirroredHash() const {
+    return key(mirrored(mine()), mirrored(red|black));
+  }
+  bool move (int column) { // Returns True if it was a valid move
+    if (!play(column)) return false;
+    lastMove = moves; // A new move, forget the moves taken back
+    return true;
+  }
+  bool unmove() { // Returns True if there was a move to take back
+    if (moves==0) return false;
+    moves-=1;
+    const Played &last = history[moves];
+    currentGameState = gameState(last.previousState);
+    bitboard &mine = currentGameState==RedTurn?red: black;
+    if (height[last.column]==rows) fullColumns-=1;
+    height[last.column]-=1;
+    mine &= ~bit(last.column*(rows+1)+height[last.column]);
+    return true;
+  }
+  bool redo() { // Returns True if there was a move to play again
+    if (moves==lastMove) return false;
+    return play(history[moves].column);
+  }
+  bool canUndo() const {
+    return moves>0;
+  }
+  bool canRedo() const {
+    return moves<lastMove;
+  }
+  // Colour of the player who made the first move of the game
+  squareType getFirstPlayer() const {
+    return blackWentFirst?Black: Red;
+  }
+  // Column of the given move of the game, from 0 to moveCount()-1
+  int getPlayedColumn(int move) const {
+    return history[move].column;
+  }
+  void newGame() { // The other player starts
+    newGame(!blackWentFirst);
+  }
+  void newGame(bool blackFirst) {
+    red = black = bitboard{0};
+    height.fill(0);
+    fullColumns = 0;
+    moves = 0;
+    lastMove = 0;
+    blackWentFirst = blackFirst;
+    currentGameState = blackWentFirst?BlackTurn: RedTurn;
+  }
+ private:
+  bool play(int column) {
+    if (currentGameState==RedWins
+        || currentGameState == BlackWins
+        || currentGameState == Tie)
+      return false; // Can not move
+    if (column<0 || column>=columns || height[column]==rows)
+      return false; // Outside of the board or row full
+    bitboard &mine = currentGameState==RedTurn?red: black;
+    int index = column*(rows+1)+height[column];
+    mine |= bit(index); //make move
+    history[moves] = {uint8_t(column), uint8_t(currentGameState)};
+    height[column]+=1;
+    moves+=1;
+    if (height[column]==rows) fullColumns+=1;
+
+    if (winsThrough(mine, index)) {
+      currentGameState=(currentGameState==RedTurn)?RedWins: BlackWins;
+      return true;
+    }
+    // This checks for a tie (all columns are full)
+    if (fullColumns==columns) {
+      currentGameState = Tie;
+      return true;
+    }
+    // Change whose turn it is
+    currentGameState = currentGameState==RedTurn?BlackTurn: RedTurn;
+    return true;
+  }
+};
+
+// The usual Connect-4 board
+typedef Board<6, 7, 4> Connect4;
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __BOOK_H
+#define __BOOK_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "mappedfile.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+OpeningBook class.
+
+Best moves of the first positions of the game,
+computed once by makebook.out and looked up by the
+Solver before it starts searching.
+
+A position and its mirror image have the same score
+and mirrored best moves, so the book only holds the
+one with the smallest hash, its canonical form. The
+file starts with a header of 8 bytes:
+
+  "C4OB" | rows | columns | toWin | 0
+
+followed by entries of 16 bytes sorted by key, in
+the byte order of the machine that wrote them.
+
+The file is mapped in memory and nothing is read
+when the book is opened: a lookup is a binary search
+that only touches the few pages it goes through.
+--------------------------------------------------*/
+
+template <class BoardType>
+class OpeningBook {
+ public:
+  struct Entry {
+    uint64_t key;     // Canonical hash of the position
+    int16_t score;    // Solver score of the position
+    uint16_t depth;   // Depth of the search that found it
+    uint8_t column;   // Best move, in the position with that hash
+    uint8_t solved;   // 1 if score is the exact game result
+    uint16_t unused = 0;
+  };
+  static_assert(sizeof(Entry)==16, "Entries are written as they are in memory");
+  static const size_t headerSize = 8;
+  static array<uint8_t, headerSize> header() {
+    return {'C', '4', 'O', 'B', uint8_t(BoardType::rows),
+            uint8_t(BoardType::columns), uint8_t(BoardType::toWin), 0};
+  }
+  // Smallest of the hashes of the position and of its mirror image.
+  // mirrored tells if it is the hash of the mirror image.
+  static uint64_t canonicalKey(const BoardType &board, bool &mirrored) {
+    const uint64_t key = board.hash(), mirrorKey = board.mirroredHash();
+    mirrored = mirrorKey<key;
+    return mirrored?mirrorKey: key;
+  }
+  // Writes a book file with the given entries, which may be in any order
+  static bool write(const string &fileName, vector<Entry> entries) {
+    sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+      return a.key<b.key;
+    });
+    ofstream file(fileName, ios::binary | ios::trunc);
+    const auto h = header();
+    file.write(reinterpret_cast<const char *>(h.data()), h.size());
+    file.write(reinterpret_cast<const char *>(entries.data()), entries.size()*sizeof(Entry));
+    return file.good();
+  }
+ private:
+  MappedFile file;
+  const Entry *entries = nullptr;
+  size_t count = 0;
+ public:
+  OpeningBook(const string &fileName): file(fileName) {
+    const auto h = header();
+    if (file.getSize()<headerSize || (file.getSize()-headerSize)%sizeof(Entry)!=0
+        || memcmp(file.getData(), h.data(), h.size())!=0) return;
+    entries = reinterpret_cast<const Entry *>(file.getData()+headerSize);
+    count = (file.getSize()-headerSize)/sizeof(Entry);
+  }
+  // Number of positions in the book, 0 if it could not be opened
+  size_t size() const {
+    return count;
+  }
+  // Looks for the position of board. If it is in the book, copies its
+  // entry with the best move turned back to the side board is seen from.
+  bool find(const BoardType &board, Entry &entry) const {
+    bool mirrored;
+    const uint64_t key = canonicalKey(board, mirrored);
+    const Entry *found = lower_bound(entries, entries+count, key,
+                                     [](const Entry &e, uint64_t key) {
+                                       return e.key<key;
+                                     });
+    if (found==entries+count || found->key!=key) return false;
+    entry = *found;
+    if (mirrored) entry.column = BoardType::columns-1-entry.column;
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,82 @@
+// Cross-check of the bitboard Board against ArrayBoard.
+//
+// Plays random games on boards of several sizes with both, mixing
+// moves, in and out of full columns, with undos and redos, and after
+// every step compares what they return, the state of the game and every
+// square. ArrayBoard has no undo, so an undo rebuilds it from the moves
+// left. Prints the number of mismatches of every size, and returns 1 if
+// there is any.
+//
+// It does not need FLTK.
+//
+// Usage: crosscheck.out [games per size] [seed]
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "board.h"
+
+using namespace std;
+
+template <int Rows, int Columns, int ToWin>
+uint64_t crossCheck(int games, mt19937 &random) {
+  typedef ArrayBoard<Rows, Columns, ToWin> Reference;
+  typedef Board<Rows, Columns, ToWin> Tested;
+  auto differ = [](const Reference &reference, const Tested &board) {
+    if (int(reference.getGameState())!=int(board.getGameState())) return true;
+    for (int row=0; row<Rows; row++)
+      for (int column=0; column<Columns; column++)
+        if (int(reference.getSquare(row, column))!=int(board.getSquare(row, column))) return true;
+    return false;
+  };
+  uniform_int_distribution<int> column(0, Columns-1), action(0, 9);
+  uint64_t mismatches = 0;
+  for (int game=0; game<games; game++) {
+    Reference reference;
+    Tested board;
+    vector<int> played; // Moves of board, including those that can be redone
+    for (int step=0; step<4*Rows*Columns; step++) {
+      const int a = action(random);
+      bool same = true;
+      if (a==0) { // Undo
+        const bool canUndo = board.moveCount()>0;
+        same = board.unmove()==canUndo;
+        reference = Reference();
+        for (int move=0; move<board.moveCount(); move++) reference.move(played[move]);
+      } else if (a==1) { // Redo
+        const bool canRedo = board.moveCount()<int(played.size());
+        const bool redone = board.redo();
+        same = redone==canRedo;
+        if (redone) same = reference.move(played[board.moveCount()-1]) && same;
+      } else {
+        const int c = column(random);
+        const bool moved = board.move(c);
+        same = moved==reference.move(c);
+        if (moved) {
+          played.resize(board.moveCount()-1);
+          played.push_back(c);
+        }
+      }
+      if (!same || differ(reference, board)) {
+        mismatches += 1;
+        break;
+      }
+    }
+  }
+  cout << Rows << "x" << Columns << ", " << ToWin << " to win: " << games << " games, "
+       << mismatches << " mismatches" << endl;
+  return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+  const int games = argc>1?atoi(argv[1]): 300;
+  mt19937 random(argc>2?atoi(argv[2]): 0);
+  uint64_t mismatches = 0;
+  mismatches += crossCheck<6, 7, 4>(games, random);
+  mismatches += crossCheck<8, 8, 4>(games, random);
+  mismatches += crossCheck<9, 9, 5>(games, random);
+  mismatches += crossCheck<15, 15, 5>(games, random);
+  mismatches += crossCheck<19, 19, 5>(games, random);
+  return mismatches>0;
+}
@@ -11,115 +11,322 @@
 #include <iostream>
 #include <array>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "board.h"
+#include "solver.h"
+#include "record.h"
 
 using namespace std;
 
-const int windowWidth = 350;
-const int windowHeight = 350;
-const double refreshPerSecond = 60;
+const int statusHeight = 50; // Space above the board for the status text
+const double computerThinkSeconds = 1;
+
+// Size in pixels of a square of the board, smaller for big boards so
+// that the window still fits on the screen
+constexpr int cellSize(int rows, int columns) {
+  return rows<=10 && columns<=10?50: 40;
+}
+
+/*--------------------------------------------------
+Observer
+--------------------------------------------------*/
+struct Observer {
+  virtual void subjectChanged()=0;
+};
 
-class Board {
+/*--------------------------------------------------
+Subject
+--------------------------------------------------*/
+class Subject {
+  vector<Observer *> observers;
  public:
-  static const int rows = 6;
-  static const int columns = 7;
-  static const int toWin = 4;
-  enum squareType {Empty, Red, Black};
-  enum gameState {RedTurn, BlackTurn, RedWins, BlackWins, Tie};
- private:
-  gameState currentGameState = RedTurn;
-  bool blackWentFirst = true;
-  array< array< squareType, columns >, rows > board;
+  void registerObserver(Observer *observer) {
+    observers.push_back(observer);
+  }
+  void removeObserver(Observer *observer) {
+    observers.erase(remove(begin(observers), end(observers), observer), end(observers));
+  }
+  void notifyObservers() const {
+    for (auto &observer: observers)
+      observer->subjectChanged();
+  }
+};
+
+/*--------------------------------------------------
+ObservableBoard class.
+
+The board of the game shown in the window, which
+tells its observers every time it changes. The
+searches play their moves on plain Board copies
+taken from it, so they never call an observer and
+are not slowed down. It can not be copied, so that
+a copy can not keep the observers by mistake.
+--------------------------------------------------*/
+
+template <int Rows, int Columns, int ToWin>
+class ObservableBoard: public Board<Rows, Columns, ToWin>, public Subject {
+  typedef Board<Rows, Columns, ToWin> BoardType;
  public:
-  Board() {
-    newGame();
-  }
-  squareType getSquare(int row, int column) const {
-    return board.at(row).at(column);
-  }
-  gameState getGameState() const {
-    return currentGameState;
-  }
-  bool move (int column) { // Returns True if it was a valid move
-    if (currentGameState==RedWins
-        || currentGameState == BlackWins
-        || currentGameState == Tie)
-      return false; // Can not move
-    // Finds where the piece should go
-    int row = 0;
-    while (row <rows && getSquare(row, column) == Empty) row+=1;
-    if (row==0) return false; // Row full
-    board.at(row-1).at(column)=currentGameState==RedTurn?Red: Black; //make move
-
-    //This code checks to see if there are four in a row
-    //Starting in every square and going in four different directions
-    //(Horizonal, vertical, two diagonals)
-    int x;
-    for (int row=0; row<rows; row++)
-      for (int column=0; column<columns; column++)
-        if (getSquare(row, column)!=Empty) {
-          squareType color = getSquare(row, column);
-
-          for (x=1; x<toWin; x++)
-            if (row+x>=rows || getSquare(row+x, column)!=color) break;
-          if (x==toWin) {
-            currentGameState=(color==Red)?RedWins: BlackWins;
-            return true;
-          }
-          for (x=1; x<toWin; x++)
-            if (column+x>=columns || getSquare(row, column+x)!=color) break;
-          if (x==toWin) {
-            currentGameState=(color==Red)?RedWins: BlackWins;
-            return true;
-          }
-          for (x=1; x<toWin; x++)
-            if (row+x>=rows || column+x>=columns || getSquare(row+x, column+x)!=color) break;
-          if (x==toWin) {
-            currentGameState=(color==Red)?RedWins: BlackWins;
-            return true;
-          }
-          for (x=1; x<toWin; x++)
-            if (row+x>=rows || column-x<0 || getSquare(row+x, column-x)!=color) break;
-          if (x==toWin) {
-            currentGameState=(color==Red)?RedWins: BlackWins;
-            return true;
-          }
-        }
-    // This checks for a tie (all top squares are occupoed)
-    for (x=0; x<columns; x++) if (getSquare(0, x)==Empty) break;
-    if (x==columns) {
-      currentGameState = Tie;
-      return true;
-    }
-    // Change whose turn it is
-    currentGameState = currentGameState==RedTurn?BlackTurn: RedTurn;
+  ObservableBoard() = default;
+  ObservableBoard(const ObservableBoard &) = delete;
+  ObservableBoard &operator=(const ObservableBoard &) = delete;
+  bool move(int column) {
+    if (!BoardType::move(column)) return false;
+    notifyObservers();
+    return true;
+  }
+  bool unmove() {
+    if (!BoardType::unmove()) return false;
+    notifyObservers();
+    return true;
+  }
+  bool redo() {
+    if (!BoardType::redo()) return false;
+    notifyObservers();
     return true;
   }
   void newGame() {
-    for (auto &c: board) for (auto &x: c) x = Empty;
-    blackWentFirst=!blackWentFirst;
-    currentGameState = blackWentFirst?BlackTurn: RedTurn;
+    BoardType::newGame();
+    notifyObservers();
+  }
+  // Replaces the whole game, with its moves to undo and redo
+  void setGame(const BoardType &game) {
+    BoardType::operator=(game);
+    notifyObservers();
   }
 };
 
+/*--------------------------------------------------
+ComputerPlayer class.
+
+Runs the Solver on a copy of the board in a
+background thread, so the window keeps answering to
+the user while the computer thinks. The thread
+never touches the board: it hands the best move of
+every depth it completes to the FLTK thread through
+Fl::awake, and the move is played from there once
+the search is over.
+
+cancel stops the search at its next node and waits
+for the thread. Every search gets a new number, and
+results of a cancelled search still on their way to
+the FLTK thread are ignored when they arrive. Its
+observers are told when it starts or stops thinking
+and when it has a better move to show.
+
+The opening book of the board size, made by
+makebook.out, is used if it is in the current
+directory.
+--------------------------------------------------*/
+
+template <int Rows, int Columns, int ToWin>
+class ComputerPlayer: public Subject {
+  typedef Board<Rows, Columns, ToWin> BoardType;
+  typedef typename Solver<BoardType>::Result Result;
+  const shared_ptr<ObservableBoard<Rows, Columns, ToWin>> board;
+  Solver<BoardType> solver;
+  thread worker;
+  atomic<bool> cancelled{false};
+  // Only used by the FLTK thread
+  unsigned search = 0;
+  bool thinking = false;
+  Result bestSoFar;
+  // Written by the worker thread, read by the FLTK thread
+  mutex pendingMutex;
+  bool hasPending = false;
+  bool pendingDone = false;
+  unsigned pendingSearch = 0;
+  Result pending;
+
+  void publish(unsigned fromSearch, const Result &result, bool done) {
+    {
+      lock_guard<mutex> lock(pendingMutex);
+      hasPending = true;
+      pendingDone = done;
+      pendingSearch = fromSearch;
+      pending = result;
+    }
+    Fl::awake(Awake_CB, this);
+  }
+  void receive() {
+    Result result;
+    bool done;
+    {
+      lock_guard<mutex> lock(pendingMutex);
+      if (!hasPending || pendingSearch!=search) return;
+      hasPending = false;
+      result = pending;
+      done = pendingDone;
+    }
+    bestSoFar = result;
+    if (done) {
+      if (worker.joinable()) worker.join();
+      thinking = false;
+      notifyObservers();
+      cout << "Computer plays " << result.column+1
+           << " score " << result.score << (result.solved?" (solved)": "")
+           << (result.fromBook?" (book)": "")
+           << " depth " << result.depth
+           << " " << result.nodes << " nodes "
+           << result.nodesPerSecond()/1000 << " kN/s" << endl;
+      board->move(result.column);
+    } else {
+      notifyObservers();
+    }
+  }
+  static void Awake_CB(void *userdata) {
+    ComputerPlayer *o = (ComputerPlayer*) userdata;
+    o->receive();
+  }
+ public:
+  ComputerPlayer(shared_ptr<ObservableBoard<Rows, Columns, ToWin>> board): board{board} {
+    solver.setThreads(thread::hardware_concurrency());
+    solver.setBook(make_shared<OpeningBook<BoardType>>(
+                     "lab11-"+to_string(Rows)+"x"+to_string(Columns)+".book"));
+  }
+  ~ComputerPlayer() {
+    cancel();
+  }
+  bool isThinking() const {
+    return thinking;
+  }
+  // Best move of the deepest search completed so far, column -1 if none
+  const Result &getBestSoFar() const {
+    return bestSoFar;
+  }
+  // Starts thinking about the move of the player whose turn it is
+  void start() {
+    cancel();
+    search += 1;
+    thinking = true;
+    bestSoFar = {};
+    cancelled = false;
+    notifyObservers();
+    worker = thread([this, position = BoardType(*board), fromSearch = search] {
+      auto progress = [this, fromSearch](const Result &result) {
+        publish(fromSearch, result, false);
+      };
+      publish(fromSearch, solver.bestMove(position, Solver<BoardType>::size, computerThinkSeconds,
+                                          &cancelled, progress), true);
+    });
+  }
+  // Stops thinking. What the search published and is not received yet
+  // is from an older search from now on, so receive drops it.
+  void cancel() {
+    if (worker.joinable()) {
+      cancelled = true;
+      worker.join();
+    }
+    search += 1;
+    {
+      lock_guard<mutex> lock(pendingMutex);
+      hasPending = false;
+    }
+    if (thinking) {
+      thinking = false;
+      notifyObservers();
+    }
+  }
+};
 
 /*--------------------------------------------------
 DispalyBoard class.
+
+Observes the board and the computer player, and
+only asks the window to draw again what they have
+changed: the columns where a square is not what was
+last drawn, and the status line if its text is
+different. Nothing is drawn while nothing changes.
 --------------------------------------------------*/
 
 
-class DisplayBoard {
-  const shared_ptr<const Board> board;
+template <int Rows, int Columns, int ToWin>
+class DisplayBoard: public Observer {
+  typedef ObservableBoard<Rows, Columns, ToWin> BoardType;
+  static const int cell = cellSize(Rows, Columns);
+  Fl_Widget *const window;
+  const shared_ptr<BoardType> board;
+  const shared_ptr<ComputerPlayer<Rows, Columns, ToWin>> computer;
+  // What is on the screen, or about to be
+  array<array<typename BoardType::squareType, Rows>, Columns> squares;
+  string message;
+  Fl_Color messageColor = FL_BLACK;
+
+  void updateMessage() {
+    switch (board->getGameState()) {
+      case BoardType::RedTurn:
+        message="Red's Turn";
+        messageColor = FL_RED;
+        break;
+      case BoardType::BlackTurn:
+        message="Black's Turn";
+        messageColor = FL_BLACK;
+        break;
+      case BoardType::Tie:
+        message="Tie";
+        messageColor = FL_BLUE;
+        break;
+      case BoardType::RedWins:
+        message="Red Wins!";
+        messageColor = FL_RED;
+        break;
+      case BoardType::BlackWins:
+        message="Black Wins!";
+        messageColor = FL_BLACK;
+        break;
+    }
+    if (computer->isThinking()) {
+      const auto &best = computer->getBestSoFar();
+      message += best.column<0?" Thinking":
+                 " " + to_string(best.column+1) + "? (depth " + to_string(best.depth) + ")";
+    }
+  }
  public:
-  DisplayBoard(const shared_ptr<const Board> board): board{board} {};
+  DisplayBoard(Fl_Widget *window, const shared_ptr<BoardType> board,
+               const shared_ptr<ComputerPlayer<Rows, Columns, ToWin>> computer):
+    window{window}, board{board}, computer{computer} {
+    for (int x=0; x<Columns; x++)
+      for (int y=0; y<Rows; y++) squares[x][y] = board->getSquare(y, x);
+    updateMessage();
+    board->registerObserver(this);
+    computer->registerObserver(this);
+  }
+  ~DisplayBoard() {
+    board->removeObserver(this);
+    computer->removeObserver(this);
+  }
+  void subjectChanged() override {
+    for (int x=0; x<Columns; x++) {
+      bool changed = false;
+      for (int y=0; y<Rows; y++) {
+        const typename BoardType::squareType square = board->getSquare(y, x);
+        if (square!=squares[x][y]) {
+          squares[x][y] = square;
+          changed = true;
+        }
+      }
+      if (changed) window->damage(FL_DAMAGE_USER1, x*cell, statusHeight, cell, Rows*cell);
+    }
+    const string before = message;
+    updateMessage();
+    if (message!=before) window->damage(FL_DAMAGE_USER1, 0, 0, Columns*cell, statusHeight);
+  }
+  // Draws the parts of the board inside the clip region set by FLTK,
+  // which only covers the damaged parts when the window is not exposed
   void draw() const {
-    fl_draw_box(FL_FLAT_BOX, 0, 50, 1000, 1000, FL_BLUE);
-    for (int x=0; x<Board::columns; x++)
-      for (int y=0; y<Board::rows; y++) {
-        switch (board->getSquare(y, x)) {
-          case Board::Red:
+    for (int x=0; x<Columns; x++) {
+      if (!fl_not_clipped(x*cell, statusHeight, cell, Rows*cell)) continue;
+      fl_draw_box(FL_FLAT_BOX, x*cell, statusHeight, cell, Rows*cell, FL_BLUE);
+      for (int y=0; y<Rows; y++) {
+        switch (squares[x][y]) {
+          case BoardType::Red:
             fl_color(FL_RED);
             break;
-          case Board::Black:
+          case BoardType::Black:
             fl_color(FL_BLACK);
             break;
           default:
@@ -127,37 +334,17 @@ class DisplayBoard {
             break;
         }
         fl_begin_polygon();
-        fl_circle(50*x+25, 50*y+75, 21);
+        fl_circle(cell*x+cell/2, cell*y+cell/2+statusHeight, cell*21/50);
         fl_end_polygon();
       }
-
-    string message;
-    switch (board->getGameState()) {
-      case Board::RedTurn:
-        message="Red's Turn";
-        fl_color(FL_RED);
-        break;
-      case Board::BlackTurn:
-        message="Black's Turn";
-        fl_color(FL_BLACK);
-        break;
-      case Board::Tie:
-        message="Tie";
-        fl_color(FL_BLUE);
-        break;
-      case Board::RedWins:
-        message="Red Wins!";
-        fl_color(FL_RED);
-        break;
-      case Board::BlackWins:
-        message="Black Wins!";
-        fl_color(FL_BLACK);
-        break;
     }
+
+    if (!fl_not_clipped(0, 0, Columns*cell, statusHeight)) return;
+    fl_color(messageColor);
     fl_font(FL_HELVETICA, 20);
     int width{0}, height{0};
     fl_measure(message.c_str(), width, height, false);
-    fl_draw(message.c_str(), 175-width/2, 30);
+    fl_draw(message.c_str(), Columns*cell/2-width/2, 30);
   }
 };
 
@@ -165,16 +352,51 @@ class DisplayBoard {
 ControllBoard class.
 --------------------------------------------------*/
 
+template <int Rows, int Columns, int ToWin>
 class ControllBoard {
-  shared_ptr<Board> board;
+  typedef ObservableBoard<Rows, Columns, ToWin> BoardType;
+  static const int cell = cellSize(Rows, Columns);
+  shared_ptr<BoardType> board;
+  shared_ptr<ComputerPlayer<Rows, Columns, ToWin>> computer;
+  typename BoardType::squareType computerColor = BoardType::Empty; // Colour played by the computer
+  bool isComputerTurn() const {
+    const typename BoardType::gameState state = board->getGameState();
+    return (state==BoardType::RedTurn && computerColor==BoardType::Red)
+           || (state==BoardType::BlackTurn && computerColor==BoardType::Black);
+  }
+  void playComputer() {
+    if (isComputerTurn()) computer->start();
+  }
+  // Saved games go to one file per board size, boards of more than 16
+  // columns can not be saved
+  static string gamesFile() {
+    return "lab11-"+to_string(Rows)+"x"+to_string(Columns)+".games";
+  }
+  void saveGame() {
+    if constexpr (Columns<=16) {
+      GameWriter<Board<Rows, Columns, ToWin>> writer(gamesFile());
+      if (!writer.write(*board)) cout << "Could not save the game to " << gamesFile() << endl;
+    }
+  }
+  void loadLastGame() {
+    if constexpr (Columns<=16) {
+      GameReader<Board<Rows, Columns, ToWin>> reader(gamesFile());
+      Board<Rows, Columns, ToWin> game;
+      if (reader.last(game)) board->setGame(game);
+    }
+  }
  public:
-  ControllBoard(shared_ptr<Board> board): board{board} {};
+  ControllBoard(shared_ptr<BoardType> board,
+                shared_ptr<ComputerPlayer<Rows, Columns, ToWin>> computer):
+    board{board}, computer{computer} {};
   bool processEvent(const int event) {
     switch (event) {
       case FL_PUSH: {
-        int col = Fl::event_x()/50;
-        if (col>=0 && col<=Board::columns) {
+        int col = Fl::event_x()/cell;
+        if (computer->isThinking()) return true; // Not your turn
+        if (col>=0 && col<Columns) {
           board->move(col);
+          playComputer();
           return true;
         }
         break;
@@ -182,9 +404,38 @@ class ControllBoard {
       case FL_KEYDOWN:
         switch (Fl::event_key()) {
           case ' ':
+            computer->cancel();
             board->newGame();
+            playComputer();
+            return true;
+          case 'u': // Undo, back to the last move of a human player
+            computer->cancel();
+            board->unmove();
+            while (isComputerTurn() && board->unmove());
+            playComputer();
+            return true;
+          case 'r': // Redo, up to the next move of a human player
+            computer->cancel();
+            board->redo();
+            while (isComputerTurn() && board->redo());
+            playComputer();
+            return true;
+          case 'c': // Computer plays: nobody -> Black -> Red -> nobody
+            computer->cancel();
+            computerColor = computerColor==BoardType::Empty?BoardType::Black:
+                            computerColor==BoardType::Black?BoardType::Red: BoardType::Empty;
+            playComputer();
+            return true;
+          case 's': // Save the moves played so far
+            saveGame();
+            return true;
+          case 'l': // Load the last saved game
+            computer->cancel();
+            loadLastGame();
+            playComputer();
             return true;
           case 'q':
+            computer->cancel();
             exit(0);
         }
     }
@@ -196,17 +447,21 @@ class ControllBoard {
 MainWindow class.
 --------------------------------------------------*/
 
+template <int Rows, int Columns, int ToWin>
 class MainWindow : public Fl_Window {
-  shared_ptr<Board> board;
-  DisplayBoard displayBoard;
-  ControllBoard controllBoard;
+  typedef ObservableBoard<Rows, Columns, ToWin> BoardType;
+  static const int cell = cellSize(Rows, Columns);
+  shared_ptr<BoardType> board;
+  shared_ptr<ComputerPlayer<Rows, Columns, ToWin>> computer;
+  DisplayBoard<Rows, Columns, ToWin> displayBoard;
+  ControllBoard<Rows, Columns, ToWin> controllBoard;
  public:
   MainWindow()
-      :Fl_Window(500, 500, windowWidth, windowHeight, "Lab 11"),
-       board{make_shared<Board>()},
-       displayBoard(board),
-       controllBoard(board) {
-    Fl::add_timeout(1.0/refreshPerSecond, Timer_CB, this);
+      :Fl_Window(500, 500, Columns*cell, Rows*cell+statusHeight, "Lab 11"),
+       board{make_shared<BoardType>()},
+       computer{make_shared<ComputerPlayer<Rows, Columns, ToWin>>(board)},
+       displayBoard(this, board, computer),
+       controllBoard(board, computer) {
     // resizable(this);
   }
   void draw() override {
@@ -216,15 +471,24 @@ class MainWindow : public Fl_Window {
   int handle(int event) override {
     return controllBoard.processEvent(event);
   }
-  static void Timer_CB(void *userdata) {
-    MainWindow *o = (MainWindow*) userdata;
-    o->redraw();
-    Fl::repeat_timeout(1.0/refreshPerSecond, Timer_CB, userdata);
-  }
 };
 
-int main(int argc, char *argv[]) {
-  MainWindow window;
-  window.show(argc, argv);
+template <int Rows, int Columns, int ToWin>
+int run(int argc, char *argv[]) {
+  MainWindow<Rows, Columns, ToWin> window;
+  if (argc>0) window.show(argc, argv);
+  else window.show();
   return Fl::run();
 }
+
+// lab11sol.out [variant]
+// where variant is one of 9x9, 15x15 or 19x19 (five in a row), or
+// nothing for the usual 6x7 board with four in a row.
+int main(int argc, char *argv[]) {
+  Fl::lock(); // Lets the computer player wake up the FLTK thread
+  const string variant = argc>1?argv[1]: "";
+  if (variant=="9x9") return run<9, 9, 5>(0, argv);
+  if (variant=="15x15") return run<15, 15, 5>(0, argv);
+  if (variant=="19x19") return run<19, 19, 5>(0, argv);
+  return run<6, 7, 4>(argc, argv);
+}
@@ -0,0 +1,89 @@
+// Opening book generator.
+//
+// Searches every position of the usual Connect-4 board reachable in
+// at most the given number of moves, mirror images counted once, and
+// writes the best move of each to an OpeningBook file. The positions
+// furthest from the start are searched first, so that their results
+// in the transposition table speed up the search of the earlier ones.
+// Positions not solved in the time given are written with the depth
+// reached, and Solver::bestMove only uses them for searches that are
+// not deeper. lab11sol.out uses the book named lab11-6x7.book.
+//
+// Usage: makebook.out book-file [moves] [seconds per position] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "board.h"
+#include "book.h"
+#include "solver.h"
+
+using namespace std;
+
+typedef OpeningBook<Connect4> Book;
+
+// Adds to positions[n] every position of n moves or less after board,
+// that is not over and was not seen yet
+void collect(Connect4 &board, int moves, vector<vector<Connect4>> &positions,
+             unordered_set<uint64_t> &seen) {
+  bool mirrored;
+  if (!seen.insert(Book::canonicalKey(board, mirrored)).second) return;
+  positions[board.moveCount()].push_back(board);
+  if (board.moveCount()==moves) return;
+  for (int column=0; column<Connect4::columns; column++)
+    if (board.canPlay(column)) {
+      board.move(column);
+      const Connect4::gameState state = board.getGameState();
+      if (state==Connect4::RedTurn || state==Connect4::BlackTurn)
+        collect(board, moves, positions, seen);
+      board.unmove();
+    }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc<2) {
+    cout << "Usage: " << argv[0] << " book-file [moves] [seconds per position] [threads]" << endl;
+    return 1;
+  }
+  const int moves = argc>2?atoi(argv[2]): 4;
+  const double seconds = argc>3?atof(argv[3]): 1;
+  Solver<Connect4> solver;
+  solver.setThreads(argc>4?atoi(argv[4]): 1);
+
+  vector<vector<Connect4>> positions(moves+1);
+  unordered_set<uint64_t> seen;
+  Connect4 start;
+  collect(start, moves, positions, seen);
+
+  vector<Book::Entry> entries;
+  const auto begin = chrono::steady_clock::now();
+  for (int n=moves; n>=0; n--) {
+    int solved = 0;
+    for (const Connect4 &board: positions[n]) {
+      const Solver<Connect4>::Result result = solver.bestMove(board, Solver<Connect4>::size, seconds);
+      // The entry is for the canonical form of the position
+      bool mirrored;
+      Book::Entry entry;
+      entry.key = Book::canonicalKey(board, mirrored);
+      entry.score = result.score;
+      entry.depth = result.depth;
+      entry.column = mirrored?Connect4::columns-1-result.column: result.column;
+      entry.solved = result.solved;
+      entries.push_back(entry);
+      solved += result.solved;
+    }
+    cout << positions[n].size() << " positions of " << n << " moves, "
+         << solved << " solved, " << fixed << setprecision(1)
+         << chrono::duration<double>(chrono::steady_clock::now()-begin).count() << "s" << endl;
+  }
+  if (!Book::write(argv[1], entries)) {
+    cout << "Could not write " << argv[1] << endl;
+    return 1;
+  }
+  cout << entries.size() << " positions written to " << argv[1] << endl;
+  return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef __MAPPEDFILE_H
+#define __MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*--------------------------------------------------
+MappedFile class.
+
+A whole file mapped in memory, read only. Nothing is
+read when it is opened: the pages of the file are
+loaded by the system the first time they are looked
+at, and shared with every other program mapping the
+same file. A file that can not be opened has no data
+and a size of 0.
+--------------------------------------------------*/
+
+class MappedFile {
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+ public:
+  MappedFile(const string &fileName, bool sequential = false) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd<0) return;
+    struct stat info;
+    if (fstat(fd, &info)==0 && info.st_size>0) {
+      void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped!=MAP_FAILED) {
+        data = static_cast<const uint8_t *>(mapped);
+        size = info.st_size;
+        // Read ahead when the file is going to be read from start to end
+        if (sequential) madvise(mapped, size, MADV_SEQUENTIAL);
+      }
+    }
+    close(fd); // The mapping stays valid
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (data) munmap(const_cast<uint8_t *>(data), size);
+  }
+  const uint8_t *getData() const {
+    return data;
+  }
+  size_t getSize() const {
+    return size;
+  }
+};
+
+#endif
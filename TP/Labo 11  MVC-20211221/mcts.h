@@ -0,0 +1,134 @@
+#ifndef __MCTS_H
+#define __MCTS_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "board.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+MonteCarlo class.
+
+Monte Carlo Tree Search player for any Board
+instance. Every playout walks down the tree, picking
+children with the UCT formula, adds the children of
+the node it stops at, finishes the game with random
+moves and counts the result in all the nodes it went
+through. The move played is the most visited child
+of the root.
+
+The nodes come from a pool allocated once by the
+constructor: the children of a node are next to each
+other in the pool, and the pool is emptied at the
+start of every search. When it is full the tree
+stops growing and the remaining playouts start from
+its leaves. One MonteCarlo, with its own pool and
+random generator, is meant to be used per thread.
+--------------------------------------------------*/
+
+template <class BoardType>
+class MonteCarlo {
+  struct Node {
+    uint32_t firstChild = 0;
+    uint8_t children = 0;
+    uint8_t column = 0;
+    bool expanded = false;
+    uint32_t visits = 0;
+    float wins = 0;  // For the player who played column, ties count half
+  };
+  vector<Node> pool;
+  size_t used = 0;
+  mt19937_64 random;
+  double exploration = 1.4;
+
+  // Plays random moves until the end of the game
+  void playout(BoardType &board) {
+    while (board.getGameState()==BoardType::RedTurn
+           || board.getGameState()==BoardType::BlackTurn) {
+      int column;
+      do column = random()%BoardType::columns; while (!board.canPlay(column));
+      board.move(column);
+    }
+  }
+  void expand(Node &node, const BoardType &board) {
+    node.expanded = true;
+    if (used+BoardType::columns>pool.size()) return; // Pool full
+    node.firstChild = used;
+    for (int column=0; column<BoardType::columns; column++)
+      if (board.canPlay(column)) {
+        pool[used] = Node{};
+        pool[used].column = column;
+        used += 1;
+        node.children += 1;
+      }
+  }
+  uint32_t select(const Node &node) {
+    const double logVisits = log(double(node.visits));
+    uint32_t best = node.firstChild;
+    double bestValue = -1;
+    for (uint32_t i=node.firstChild; i<node.firstChild+node.children; i++) {
+      const Node &child = pool[i];
+      if (child.visits==0) return i;
+      double value = child.wins/child.visits
+                     + exploration*sqrt(logVisits/child.visits);
+      if (value>bestValue) {
+        bestValue = value;
+        best = i;
+      }
+    }
+    return best;
+  }
+ public:
+  MonteCarlo(size_t poolSize, uint64_t seed): pool(poolSize), random(seed) {}
+  // Runs the given number of playouts from board, which must not be
+  // over, and returns the column to play.
+  int bestMove(const BoardType &board, int playouts) {
+    used = 1;
+    pool[0] = Node{};
+    array<uint32_t, BoardType::rows*BoardType::columns+1> path;
+    for (int p=0; p<playouts; p++) {
+      BoardType position = board;
+      int length = 0;
+      uint32_t node = 0;
+      path[length++] = node;
+      while (pool[node].expanded && pool[node].children>0) {
+        node = select(pool[node]);
+        position.move(pool[node].column);
+        path[length++] = node;
+      }
+      if (position.getGameState()==BoardType::RedTurn
+          || position.getGameState()==BoardType::BlackTurn) {
+        expand(pool[node], position);
+        if (pool[node].children>0) {
+          node = pool[node].firstChild + random()%pool[node].children;
+          position.move(pool[node].column);
+          path[length++] = node;
+        }
+        playout(position);
+      }
+
+      // Count the result for the player who moved into every node: the
+      // player to move at the root for the odd nodes of the path, the
+      // other player for the even ones.
+      const auto state = position.getGameState();
+      const float rootReward = state==BoardType::Tie?0.5f:
+                               (state==BoardType::RedWins)==(board.getGameState()==BoardType::RedTurn)?1: 0;
+      for (int i=0; i<length; i++) {
+        pool[path[i]].visits += 1;
+        pool[path[i]].wins += i%2==1?rootReward: 1-rootReward;
+      }
+    }
+    const Node &root = pool[0];
+    uint32_t best = root.firstChild;
+    for (uint32_t i=root.firstChild; i<root.firstChild+root.children; i++)
+      if (pool[i].visits>pool[best].visits) best = i;
+    return pool[best].column;
+  }
+};
+
+#endif
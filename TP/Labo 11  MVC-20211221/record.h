@@ -0,0 +1,164 @@
+#ifndef __RECORD_H
+#define __RECORD_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "mappedfile.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+Game records.
+
+A file of games starts with a header of 8 bytes:
+
+  "C4GR" | rows | columns | toWin | 0
+
+so that games of one board size are never replayed
+on another. Then every game takes:
+
+  2 bytes, little endian: number of moves (15 bits),
+                          top bit set if Black started
+  (moves+1)/2 bytes: the columns played, one per
+                     nibble, the first move of every
+                     byte in its low nibble
+
+A game of 42 moves fits in 23 bytes. Only boards of
+16 columns or less can be recorded.
+--------------------------------------------------*/
+
+const size_t recordHeaderSize = 8;
+
+template <class BoardType>
+array<uint8_t, recordHeaderSize> recordHeader() {
+  static_assert(BoardType::columns <= 16, "A column must fit in a nibble");
+  static_assert(BoardType::rows*BoardType::columns < 1 << 15, "Too many moves for a record");
+  return {'C', '4', 'G', 'R', uint8_t(BoardType::rows),
+          uint8_t(BoardType::columns), uint8_t(BoardType::toWin), 0};
+}
+
+/*--------------------------------------------------
+GameWriter class.
+
+Appends the moves played on a board to a file of
+games, writing the file header first if the file is
+new. A file of another board size is left alone and
+the writer is then not open.
+
+encode does the same into a buffer, so that threads
+can record games on their own and write them all at
+the end.
+--------------------------------------------------*/
+
+template <class BoardType>
+class GameWriter {
+  ofstream file;
+ public:
+  GameWriter(const string &fileName) {
+    const auto header = recordHeader<BoardType>();
+    ifstream existing(fileName, ios::binary);
+    array<uint8_t, recordHeaderSize> found;
+    if (existing.read(reinterpret_cast<char *>(found.data()), found.size())) {
+      if (found!=header) return; // Another board size
+    } else if (existing.gcount()>0) {
+      return; // Not a file of games
+    }
+    existing.close();
+    file.open(fileName, ios::binary | ios::app);
+    if (file.tellp()==0)
+      file.write(reinterpret_cast<const char *>(header.data()), header.size());
+  }
+  bool isOpen() const {
+    return file.is_open() && file.good();
+  }
+  // Adds the record of the game on board to the end of buffer
+  static void encode(const BoardType &board, vector<uint8_t> &buffer) {
+    const int moves = board.moveCount();
+    const int first = board.getFirstPlayer()==BoardType::Black?0x8000: 0;
+    buffer.push_back(uint8_t(moves));
+    buffer.push_back(uint8_t((moves | first) >> 8));
+    for (int i=0; i<moves; i+=2)
+      buffer.push_back(uint8_t(board.getPlayedColumn(i)
+                               | (i+1<moves?board.getPlayedColumn(i+1) << 4: 0)));
+  }
+  // Writes records made by encode
+  bool write(const vector<uint8_t> &records) {
+    file.write(reinterpret_cast<const char *>(records.data()), records.size());
+    return isOpen();
+  }
+  bool write(const BoardType &board) {
+    vector<uint8_t> record;
+    encode(board, record);
+    return write(record);
+  }
+};
+
+/*--------------------------------------------------
+GameReader class.
+
+Replays the games of a file one after the other on
+a board. The file is mapped in memory rather than
+read, so the games are decoded straight from the
+page cache and nothing is allocated, whatever the
+number of games: a corpus of millions of games is
+only limited by the speed of Board::move.
+--------------------------------------------------*/
+
+template <class BoardType>
+class GameReader {
+  MappedFile file;
+  const uint8_t *data;
+  size_t size;
+  size_t position = recordHeaderSize;
+  bool valid;
+ public:
+  GameReader(const string &fileName):
+    file(fileName, true), data{file.getData()}, size{file.getSize()} {
+    const auto header = recordHeader<BoardType>();
+    valid = size>=recordHeaderSize && memcmp(data, header.data(), header.size())==0;
+  }
+  // True if the file could be opened and holds games of this board size
+  bool isValid() const {
+    return valid;
+  }
+  // Goes back to the first game
+  void rewind() {
+    position = recordHeaderSize;
+  }
+  // Replays the next game on board. Returns false at the end of the
+  // file, or if the record is cut short or has a move that can not be
+  // played.
+  bool next(BoardType &board) {
+    if (!valid || position+2>size) return false;
+    const unsigned header = data[position] | data[position+1] << 8;
+    const int moves = header & 0x7FFF;
+    const size_t length = 2+(moves+1)/2;
+    if (position+length>size) return false;
+    const uint8_t *columns = data+position+2;
+    position += length;
+    board.newGame((header & 0x8000)!=0);
+    for (int i=0; i<moves; i++)
+      if (!board.move(i%2==0?columns[i/2] & 0xF: columns[i/2] >> 4)) return false;
+    return true;
+  }
+  // Replays the games up to the first one that can not be read, each on
+  // a board of its own, and copies the last one that could to board.
+  // Returns false, leaving board alone, if there is none.
+  bool last(BoardType &board) {
+    BoardType game;
+    bool found = false;
+    while (next(game)) {
+      board = game;
+      found = true;
+    }
+    return found;
+  }
+};
+
+#endif
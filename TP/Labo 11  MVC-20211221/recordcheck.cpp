@@ -0,0 +1,98 @@
+// Check of GameWriter and GameReader.
+//
+// Writes random games to a file and reads them back, then adds a last
+// record with a move that can not be played, then one cut short, and
+// checks both times that GameReader::last gives the last game that is
+// whole. Prints what failed, and returns 1 if anything did.
+//
+// It does not need FLTK.
+//
+// Usage: recordcheck.out [games] [file]
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "record.h"
+
+using namespace std;
+
+bool sameGame(const Connect4 &a, const Connect4 &b) {
+  if (a.moveCount()!=b.moveCount() || a.getFirstPlayer()!=b.getFirstPlayer()
+      || a.getGameState()!=b.getGameState())
+    return false;
+  for (int move=0; move<a.moveCount(); move++)
+    if (a.getPlayedColumn(move)!=b.getPlayedColumn(move)) return false;
+  return true;
+}
+
+// Adds bytes to the end of the file
+void append(const string &fileName, const vector<uint8_t> &bytes) {
+  FILE *file = fopen(fileName.c_str(), "ab");
+  if (!file) return;
+  fwrite(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+}
+
+// Checks that the last whole game of the file is expected
+int checkLast(const string &fileName, const Connect4 &expected, const string &what) {
+  GameReader<Connect4> reader(fileName);
+  Connect4 game;
+  if (reader.last(game) && sameGame(game, expected)) return 0;
+  cout << what << ": the last game read is not the last one written" << endl;
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  const int games = argc>1?atoi(argv[1]): 100;
+  const string fileName = argc>2?argv[2]: "recordcheck.games";
+  mt19937 random(0);
+  uniform_int_distribution<int> column(0, Connect4::columns-1);
+  vector<Connect4> written(games);
+  auto writeGames = [&] {
+    remove(fileName.c_str());
+    GameWriter<Connect4> writer(fileName);
+    for (int i=0; i<games; i++) {
+      Connect4 &board = written[i];
+      board.newGame(i%2==0);
+      while (board.getGameState()==Connect4::RedTurn || board.getGameState()==Connect4::BlackTurn)
+        board.move(column(random));
+      if (!writer.write(board)) return false;
+    }
+    return true;
+  };
+  if (!writeGames()) {
+    cout << "Could not write to " << fileName << endl;
+    return 1;
+  }
+
+  int failures = 0;
+  GameReader<Connect4> reader(fileName);
+  Connect4 game;
+  int read = 0;
+  while (reader.next(game)) failures += !sameGame(game, written[read++]);
+  if (read!=games) {
+    cout << read << " games read out of " << games << endl;
+    failures += 1;
+  }
+  failures += checkLast(fileName, written.back(), "Whole file");
+
+  // A game of 43 moves in the middle column, which is full after 6,
+  // so the board has moves played when the record turns out bad
+  vector<uint8_t> illegal = {43, 0};
+  illegal.resize(2+22, 0x33);
+  append(fileName, illegal);
+  failures += checkLast(fileName, written.back(), "Illegal move");
+
+  // A record of 10 moves with the columns of only 4
+  writeGames();
+  append(fileName, {10, 0, 0x10, 0x32});
+  failures += checkLast(fileName, written.back(), "Cut short");
+  remove(fileName.c_str());
+
+  cout << games << " games written and read back, " << failures << " failures" << endl;
+  return failures>0;
+}
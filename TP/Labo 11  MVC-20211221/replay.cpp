@@ -0,0 +1,75 @@
+// Opening statistics of a file of games.
+//
+// Replays every game of a file written by GameWriter (for example by
+// selfplay.out) and prints, for every opening of the given number of
+// moves, how often the player who started won, lost or tied, followed
+// by the number of games and moves replayed per second.
+//
+// Usage: replay.out games-file [opening moves]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "board.h"
+#include "record.h"
+
+using namespace std;
+
+struct Outcomes {
+  uint64_t wins = 0;   // For the player who started
+  uint64_t losses = 0;
+  uint64_t ties = 0;
+};
+
+int main(int argc, char *argv[]) {
+  if (argc<2) {
+    cout << "Usage: " << argv[0] << " games-file [opening moves]" << endl;
+    return 1;
+  }
+  const int openingMoves = argc>2?atoi(argv[2]): 1;
+  GameReader<Connect4> reader(argv[1]);
+  if (!reader.isValid()) {
+    cout << argv[1] << " is not a file of Connect-4 games" << endl;
+    return 1;
+  }
+
+  // An opening is written as its columns, 1 to 7. Games shorter than
+  // the opening are counted with the moves they have.
+  map<string, Outcomes> openings;
+  string opening;
+  uint64_t games = 0, moves = 0;
+  Connect4 board;
+  const auto start = chrono::steady_clock::now();
+  while (reader.next(board)) {
+    games += 1;
+    moves += board.moveCount();
+    opening.clear();
+    for (int i=0; i<openingMoves && i<board.moveCount(); i++)
+      opening += char('1'+board.getPlayedColumn(i));
+    Outcomes &outcomes = openings[opening];
+    const Connect4::gameState state = board.getGameState();
+    if (state==Connect4::RedWins || state==Connect4::BlackWins) {
+      const bool firstWon = (state==Connect4::RedWins)==(board.getFirstPlayer()==Connect4::Red);
+      (firstWon?outcomes.wins: outcomes.losses) += 1;
+    } else {
+      outcomes.ties += 1;
+    }
+  }
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+  cout << "opening    games   wins  losses   ties" << endl << fixed << setprecision(1);
+  for (const auto &[name, outcomes]: openings) {
+    const uint64_t total = outcomes.wins+outcomes.losses+outcomes.ties;
+    cout << left << setw(8) << name << right << setw(8) << total
+         << setw(6) << 100.0*outcomes.wins/total << "%"
+         << setw(7) << 100.0*outcomes.losses/total << "%"
+         << setw(6) << 100.0*outcomes.ties/total << "%" << endl;
+  }
+  cout << games << " games, " << moves << " moves in " << setprecision(3) << seconds << "s, "
+       << setprecision(0) << (seconds>0?games/seconds: 0) << " games/s, "
+       << (seconds>0?moves/seconds: 0) << " moves/s" << endl;
+  return 0;
+}
@@ -0,0 +1,111 @@
+// Headless self-play of the Monte Carlo player.
+//
+// Plays games between two MonteCarlo players on the usual Connect-4
+// board, on all cores, and prints the number of wins of each colour,
+// the ties, and how many playouts were run per second. Red and Black
+// can be given a different number of playouts per move to compare
+// their strength. The first player alternates from one game to the
+// next. The games can be written to a file of games, see record.h.
+//
+// Usage: selfplay.out [games] [red playouts] [black playouts] [threads] [games file]
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "mcts.h"
+#include "record.h"
+
+using namespace std;
+
+struct Statistics {
+  uint64_t games = 0;
+  uint64_t redWins = 0;
+  uint64_t blackWins = 0;
+  uint64_t ties = 0;
+  uint64_t firstPlayerWins = 0;
+  uint64_t playouts = 0;
+  vector<uint8_t> records;
+};
+
+int main(int argc, char *argv[]) {
+  const int games = argc>1?atoi(argv[1]): 1000;
+  const int redPlayouts = argc>2?atoi(argv[2]): 1000;
+  const int blackPlayouts = argc>3?atoi(argv[3]): redPlayouts;
+  const int threads = max(1, argc>4?atoi(argv[4]): int(thread::hardware_concurrency()));
+  const string gamesFile = argc>5?argv[5]: "";
+  const size_t poolSize = size_t(max(redPlayouts, blackPlayouts)+1)*Connect4::columns;
+
+  atomic<int> nextGame{0};
+  vector<Statistics> statistics(threads);
+  const auto start = chrono::steady_clock::now();
+  vector<thread> workers;
+  for (int id=0; id<threads; id++)
+    workers.emplace_back([&, id] {
+      MonteCarlo<Connect4> player(poolSize, 12345+id);
+      Statistics &mine = statistics[id];
+      for (int game = nextGame++; game<games; game = nextGame++) {
+        Connect4 board;
+        if (game%2==1) board.newGame(); // The other colour starts
+        const bool redFirst = board.getGameState()==Connect4::RedTurn;
+        while (board.getGameState()==Connect4::RedTurn
+               || board.getGameState()==Connect4::BlackTurn) {
+          const int playouts = board.getGameState()==Connect4::RedTurn?redPlayouts: blackPlayouts;
+          board.move(player.bestMove(board, playouts));
+          mine.playouts += playouts;
+        }
+        mine.games += 1;
+        if (!gamesFile.empty()) GameWriter<Connect4>::encode(board, mine.records);
+        switch (board.getGameState()) {
+          case Connect4::RedWins:
+            mine.redWins += 1;
+            mine.firstPlayerWins += redFirst;
+            break;
+          case Connect4::BlackWins:
+            mine.blackWins += 1;
+            mine.firstPlayerWins += !redFirst;
+            break;
+          default:
+            mine.ties += 1;
+        }
+      }
+    });
+  for (auto &worker: workers) worker.join();
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+  if (!gamesFile.empty()) {
+    GameWriter<Connect4> writer(gamesFile);
+    bool written = writer.isOpen();
+    for (const Statistics &s: statistics) written = written && writer.write(s.records);
+    if (!written) cout << "Could not write the games to " << gamesFile << endl;
+  }
+
+  Statistics total;
+  for (const Statistics &s: statistics) {
+    total.games += s.games;
+    total.redWins += s.redWins;
+    total.blackWins += s.blackWins;
+    total.ties += s.ties;
+    total.firstPlayerWins += s.firstPlayerWins;
+    total.playouts += s.playouts;
+  }
+  auto percent = [&](uint64_t n) {
+    return 100.0*n/(total.games>0?total.games: 1);
+  };
+  cout << fixed << setprecision(1)
+       << total.games << " games on " << threads << " threads in " << seconds << "s" << endl
+       << "Red   (" << redPlayouts << " playouts) wins " << total.redWins
+       << " (" << percent(total.redWins) << "%)" << endl
+       << "Black (" << blackPlayouts << " playouts) wins " << total.blackWins
+       << " (" << percent(total.blackWins) << "%)" << endl
+       << "Ties " << total.ties << " (" << percent(total.ties) << "%)" << endl
+       << "First player wins " << total.firstPlayerWins
+       << " (" << percent(total.firstPlayerWins) << "%)" << endl
+       << setprecision(0) << total.playouts/seconds << " playouts/s, "
+       << setprecision(1) << total.games/seconds << " games/s" << endl;
+  return 0;
+}
@@ -0,0 +1,60 @@
+// Headless front end of the Solver.
+//
+// Reads one position per line on the standard input, given as the
+// columns played from the start of the game (1 to 7), for example:
+//
+//   4453
+//
+// and prints the best move (1 to 7), its score, the search depth,
+// the number of nodes searched, the time taken and nodes per second.
+// Positions found in the opening book, if one is given, are not
+// searched.
+//
+// Usage: solve.out [depth] [seconds] [threads] [book-file]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "board.h"
+#include "solver.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  int depth = argc>1?atoi(argv[1]): Solver<Connect4>::size;
+  double seconds = argc>2?atof(argv[2]): 0;
+  Solver<Connect4> solver;
+  solver.setThreads(argc>3?atoi(argv[3]): 1);
+  if (argc>4) solver.setBook(make_shared<OpeningBook<Connect4>>(argv[4]));
+  string line;
+  while (getline(cin, line)) {
+    Connect4 board;
+    bool valid = true;
+    for (char c: line)
+      if (c>='1' && c<='0'+Connect4::columns) {
+        Connect4::gameState before = board.getGameState();
+        if (!board.move(c-'1') || board.getGameState()==Connect4::Tie
+            || board.getGameState()!=(before==Connect4::RedTurn?Connect4::BlackTurn: Connect4::RedTurn))
+          valid = false;
+      }
+    if (!valid) {
+      cout << line << " invalid or finished position" << endl;
+      continue;
+    }
+    Solver<Connect4>::Result result = solver.bestMove(board, depth, seconds);
+    cout << line
+         << " move " << result.column+1
+         << " score " << result.score
+         << (result.solved?" (solved)": "")
+         << (result.fromBook?" (book)": "")
+         << " depth " << result.depth
+         << " nodes " << result.nodes
+         << " time " << fixed << setprecision(3) << result.seconds << "s"
+         << " " << setprecision(0) << result.nodesPerSecond()/1000 << " kN/s"
+         << defaultfloat << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,337 @@
+#ifndef __SOLVER_H
+#define __SOLVER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "book.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+TranspositionTable class.
+
+Fixed-size table of results of already searched
+positions, indexed by Board::hash. When two
+positions fall on the same slot the newest one wins.
+
+The key is first mixed by a multiplication with an
+odd constant, which gives a different number for
+every key. The top bits of that number are the slot
+and every entry is packed in 64 bits:
+
+  low 41 bits of the mixed key | depth (9 bits) | lower bound (1 bit) | score+4096 (13 bits)
+
+With 2^23 slots or more, slot and entry hold all 64
+bits of the mixed key, so an entry is never mistaken
+for another position.
+
+Since an entry is a single 64-bit word, it is read
+and written as one relaxed atomic and the table can
+be shared by several search threads without locks:
+a thread sees either the old or the new entry,
+never half of each.
+--------------------------------------------------*/
+
+class TranspositionTable {
+ public:
+  enum boundType {Upper, Lower};
+  struct Entry {
+    int score;
+    int depth;
+    boundType bound;
+  };
+  static const int maxDepth = (1 << 9)-1;
+  static const int maxScore = (1 << 12)-1;
+ private:
+  vector<atomic<uint64_t>> entries;
+  int sizeLog2;
+
+  static uint64_t mixed(uint64_t key) {
+    return key*0x9E3779B97F4A7C15ull;
+  }
+  size_t index(uint64_t key) const {
+    return mixed(key) >> (64-sizeLog2);
+  }
+ public:
+  TranspositionTable(int sizeLog2 = 23): entries(size_t{1} << sizeLog2), sizeLog2{sizeLog2} {}
+  void clear() {
+    for (auto &e: entries) e.store(0, memory_order_relaxed);
+  }
+  void put(uint64_t key, int score, int depth, boundType bound) {
+    entries[index(key)].store(mixed(key) << 23 | uint64_t(depth) << 14
+                              | uint64_t(bound) << 13 | uint64_t(score+maxScore+1),
+                              memory_order_relaxed);
+  }
+  bool get(uint64_t key, Entry &entry) const {
+    uint64_t e = entries[index(key)].load(memory_order_relaxed);
+    if (e == 0 || e >> 23 != (mixed(key) << 23) >> 23) return false;
+    entry = {int(e & 0x1FFF)-maxScore-1, int(e >> 14 & maxDepth), boundType(e >> 13 & 1)};
+    return true;
+  }
+};
+
+/*--------------------------------------------------
+Solver class.
+
+Computer player for any Board instance. It runs a
+negamax search with alpha-beta pruning, tries the
+center columns first and remembers the positions it
+has already seen in a TranspositionTable.
+
+Scores are seen from the player whose turn it is:
+a win with k of their own pieces left to play is
+worth k+1, a loss the opposite, and 0 is a tie or a
+position the search did not look deep enough into.
+
+bestMove deepens the search one move at a time until
+the end of the game, the depth limit or the time
+budget is reached, and returns the move of the
+deepest search it completed.
+
+With more than one thread (lazy SMP), every thread
+runs that same search of the same position, each
+with a slightly different move order, and they only
+cooperate through the shared table: what one thread
+finds lets the others cut their search short. The
+first thread to finish gives the answer and stops
+the others.
+
+The search can also be stopped from another thread
+through a cancel flag, and report the best move of
+every depth it completes, so that it can run in the
+background of a user interface.
+
+When it is given an OpeningBook, bestMove first
+looks for the position there, and only answers from
+the book if the entry is solved or was searched at
+least as deep as asked. Otherwise it searches.
+--------------------------------------------------*/
+
+template <class BoardType>
+class Solver {
+ public:
+  static const int size = BoardType::rows*BoardType::columns;
+  static_assert((size+1)/2 <= TranspositionTable::maxScore, "Board too big for the table");
+  struct Result {
+    int column = -1;        // Best move found, -1 if there is none
+    int score = 0;          // Score of that move
+    int depth = 0;          // Depth of the deepest completed search
+    bool solved = false;    // True if the score is the exact game result
+    bool fromBook = false;  // True if it was found in the opening book
+    uint64_t nodes = 0;     // Nodes searched by all threads
+    double seconds = 0;
+    double nodesPerSecond() const {
+      return seconds>0?nodes/seconds: 0;
+    }
+  };
+ private:
+  // One search thread. Its own node count and move order, the rest is
+  // shared through the Solver.
+  class Worker {
+    Solver &solver;
+    const int id;
+    array<int, BoardType::columns> order;
+   public:
+    uint64_t nodes = 0;
+    Result result;
+
+    Worker(Solver &solver, int id): solver{solver}, id{id} {
+      // Center columns first: 3, 2, 4, 1, 5, 0, 6 on the usual board.
+      // Other threads swap the columns that are as far from the center,
+      // and the columns of successive pairs, to search in another order.
+      for (int i=0; i<BoardType::columns; i++)
+        order[i] = BoardType::columns/2 + ((i%2==0)!=(id%2==1)?1: -1)*(i+1)/2;
+      for (int i=1; i+1<BoardType::columns && id>1; i+=2)
+        if ((i/2+id/2)%2==0) swap(order[i], order[i+1]);
+    }
+    bool outOfTime() {
+      if (solver.stop.load(memory_order_relaxed)) return true;
+      if (solver.cancel && solver.cancel->load(memory_order_relaxed))
+        solver.stop = true;
+      if ((nodes & 4095)==0 && solver.hasDeadline
+          && chrono::steady_clock::now() >= solver.deadline)
+        solver.stop = true;
+      return solver.stop.load(memory_order_relaxed);
+    }
+    int negamax(BoardType &board, int alpha, int beta, int depth) {
+      nodes+=1;
+      if (outOfTime()) return 0;
+
+      const int moves = board.moveCount();
+      if (board.canWinNext()) return (size+1-moves)/2;
+      const unsigned allowed = board.nonLosingColumns();
+      if (allowed==0) return -(size-moves)/2;
+      if (moves>=size-2) return 0;
+      if (depth==0) return 0;
+
+      // A win can not come before our next move, nor a loss before theirs
+      int max = (size-1-moves)/2;
+      int min = -(size-2-moves)/2;
+      const int exactDepth = depth<size-moves?depth: size-moves;
+      TranspositionTable::Entry entry;
+      if (solver.table.get(board.hash(), entry) && entry.depth>=exactDepth) {
+        if (entry.bound==TranspositionTable::Upper) {
+          if (entry.score<max) max = entry.score;
+        } else if (entry.score>min) {
+          min = entry.score;
+        }
+      }
+      if (alpha<min) {
+        alpha = min;
+        if (alpha>=beta) return alpha;
+      }
+      if (beta>max) {
+        beta = max;
+        if (alpha>=beta) return beta;
+      }
+
+      // Moves creating the most threats first, then in the thread's order
+      array<int, BoardType::columns> sorted, threats;
+      int count = 0;
+      for (int column: order)
+        if (allowed & 1u << column) {
+          int t = board.threatsAfter(column), i = count++;
+          for (; i>0 && threats[i-1]<t; i--) {
+            sorted[i] = sorted[i-1];
+            threats[i] = threats[i-1];
+          }
+          sorted[i] = column;
+          threats[i] = t;
+        }
+
+      for (int i=0; i<count; i++) {
+        board.move(sorted[i]);
+        int score = -negamax(board, -beta, -alpha, depth-1);
+        board.unmove();
+        if (solver.stop.load(memory_order_relaxed)) return 0;
+        if (score>=beta) {
+          solver.table.put(board.hash(), score, exactDepth, TranspositionTable::Lower);
+          return score;
+        }
+        if (score>alpha) alpha = score;
+      }
+      solver.table.put(board.hash(), alpha, exactDepth, TranspositionTable::Upper);
+      return alpha;
+    }
+    // Iterative deepening from the root, on the thread's own copy of
+    // the board. Returns true if this thread finished the search, false
+    // if it was stopped.
+    bool search(BoardType board, int maxDepth) {
+      const int remaining = size-board.moveCount();
+      for (int depth=1; depth<=maxDepth; depth++) {
+        int alpha = -size, bestColumn = -1;
+        for (int column: order)
+          if (board.canPlay(column)) {
+            if (bestColumn<0) bestColumn = column;
+            if (board.isWinningMove(column)) {
+              alpha = (size+1-board.moveCount())/2;
+              bestColumn = column;
+              break;
+            }
+            board.move(column);
+            int score = -negamax(board, -size, -alpha, depth-1);
+            board.unmove();
+            if (solver.stop.load(memory_order_relaxed)) break;
+            if (score>alpha) {
+              alpha = score;
+              bestColumn = column;
+            }
+          }
+        if (solver.stop.load(memory_order_relaxed) && result.column>=0) return false;
+        result.column = bestColumn;
+        result.score = alpha;
+        result.depth = depth;
+        // A win or loss found within the depth is exact, so is anything
+        // found by a search that went to the end of the game.
+        result.solved = !solver.stop && (depth==remaining || alpha!=0);
+        if (id==0 && solver.progress) solver.progress(result);
+        if (result.solved) break;
+      }
+      return !solver.stop.exchange(true);
+    }
+  };
+
+  TranspositionTable table;
+  shared_ptr<const OpeningBook<BoardType>> book;
+  int threads = 1;
+  atomic<bool> stop{false};
+  const atomic<bool> *cancel = nullptr;
+  function<void(const Result &)> progress;
+  chrono::steady_clock::time_point deadline;
+  bool hasDeadline = false;
+ public:
+  Solver(int tableSizeLog2 = 23): table(tableSizeLog2) {}
+  void setThreads(int n) {
+    threads = n>0?n: 1;
+  }
+  int getThreads() const {
+    return threads;
+  }
+  void setBook(shared_ptr<const OpeningBook<BoardType>> book) {
+    this->book = book;
+  }
+  // Forgets every position searched so far
+  void clear() {
+    table.clear();
+  }
+  // Searches until maxDepth moves ahead or maxSeconds have passed.
+  // A maxSeconds of 0 means there is no time limit. The search also
+  // stops as soon as *cancel becomes true, and calls progress with the
+  // best move so far every time a depth is completed.
+  Result bestMove(const BoardType &board, int maxDepth = size, double maxSeconds = 0,
+                  const atomic<bool> *cancel = nullptr,
+                  function<void(const Result &)> progress = nullptr) {
+    const auto start = chrono::steady_clock::now();
+    const int remaining = size-board.moveCount();
+    if (maxDepth>remaining) maxDepth = remaining;
+    typename OpeningBook<BoardType>::Entry entry;
+    if (book && book->find(board, entry) && (entry.solved || entry.depth>=maxDepth)) {
+      Result result;
+      result.column = entry.column;
+      result.score = entry.score;
+      result.depth = entry.depth;
+      result.solved = entry.solved;
+      result.fromBook = true;
+      result.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+      return result;
+    }
+    this->cancel = cancel;
+    this->progress = progress;
+    hasDeadline = maxSeconds>0;
+    deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                 chrono::duration<double>(maxSeconds));
+    stop = false;
+
+    vector<Worker> workers;
+    for (int id=0; id<threads; id++) workers.emplace_back(*this, id);
+    vector<thread> helpers;
+    for (int id=1; id<threads; id++)
+      helpers.emplace_back([&, id] {
+        workers[id].search(board, maxDepth);
+      });
+    workers[0].search(board, maxDepth);
+    for (auto &helper: helpers) helper.join();
+
+    // The answer comes from the deepest search that was completed,
+    // which is the one of the thread that finished first if any did.
+    Result result = workers[0].result;
+    for (auto &worker: workers)
+      if (worker.result.depth>result.depth
+          || (worker.result.solved && !result.solved))
+        result = worker.result;
+    result.nodes = 0;
+    for (auto &worker: workers) result.nodes += worker.nodes;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    return result;
+  }
+};
+
+#endif
@@ -0,0 +1,48 @@
+// Benchmark of Minefield::makeVisible.
+//
+// Makes fields of 4096x4096 cells with few bombs, reveals one empty
+// cell near the middle of each, which floods most of the field, and
+// prints the number of cells revealed and the time it took per cell.
+//
+// It does not need FLTK.
+//
+// Usage: floodbench.out [size] [bombs per 256 cells] [fields]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "minefield.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  const int size = argc>1?atoi(argv[1]): 4096;
+  const int bombsPer256 = argc>2?atoi(argv[2]): 2;
+  const int fields = argc>3?atoi(argv[3]): 5;
+
+  Minefield field;
+  size_t totalRevealed = 0;
+  double totalSeconds = 0;
+  for (int seed = 0; seed<fields; seed++) {
+    field.initialize(size, size, seed, bombsPer256);
+    // The first cell without bombs around, from the middle
+    int x = size/2, y = size/2;
+    while (x<size && (field.isBomb(x, y) || field.neighborBombCount(x, y)>0)) x++;
+    if (x==size) continue;
+
+    const auto start = chrono::steady_clock::now();
+    const size_t revealed = field.makeVisible(x, y);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    totalRevealed += revealed;
+    totalSeconds += seconds;
+    cout << fixed << setprecision(1) << "field " << seed << ": "
+         << revealed << " cells revealed ("
+         << 100.0*revealed/(double(size)*size) << "%) in "
+         << setprecision(2) << seconds*1000 << " ms" << endl;
+  }
+  if (totalRevealed>0)
+    cout << fixed << setprecision(2) << totalSeconds*1e9/totalRevealed << " ns per cell, "
+         << setprecision(0) << totalRevealed/totalSeconds/1e6 << " million cells per second" << endl;
+  return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef __GENERATOR_H
+#define __GENERATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "minefield.h"
+#include "solver.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+
+Generator class.
+
+Makes fields that can be won without guessing from
+a given first click: the first cell and its
+neighbors have no bomb, and from there on a Solver
+always finds a cell that is safe for sure, until all
+of them are visible.
+
+Random fields rarely are like that, so every thread
+of a ThreadPool makes candidate fields and plays
+them with its own Solver, until one of them is won.
+Each thread has its own random generator, seeded
+from the seed given to generate and the number of
+the thread, which draws the seed of every candidate
+for Minefield::initialize. Which thread finds a
+field first varies from run to run, but every field
+is given by its seed.
+
+--------------------------------------------------*/
+
+class Generator {
+  ThreadPool pool;
+  atomic<size_t> tried{0};
+
+  // The random generator of a thread
+  static mt19937_64 threadRandom(uint64_t seed, int thread) {
+    seed_seq sequence{uint32_t(seed), uint32_t(seed >> 32), uint32_t(thread)};
+    return mt19937_64(sequence);
+  }
+
+  // Plays the field from the first click, only ever revealing cells the
+  // solver finds safe, and tells if it is won that way
+  static bool playable(Minefield field, int firstX, int firstY, Solver &solver) {
+    field.makeVisible(firstX, firstY);
+    while (!field.solved()) {
+      const Solver::Result result = solver.solve(field);
+      if (result.safeCells==0) return false;
+      for (const auto &cell: result.frontier)
+        if (cell.mine==0) field.makeVisible(cell.x, cell.y);
+    }
+    return true;
+  }
+ public:
+  Generator(int threads = thread::hardware_concurrency()): pool(threads) {}
+  int threads() const {
+    return pool.size();
+  }
+  // Candidate fields made by the last call to generate
+  size_t candidates() const {
+    return tried;
+  }
+  // Makes field a width x height field, with bombsPer256 bombs in 256
+  // cells, that can be won without guessing from firstX, firstY. Gives
+  // up after maxCandidates fields, or once maxSeconds have passed if it
+  // is not 0, and leaves the first one of thread 0, which is still safe
+  // on the first click. Returns true if it found one.
+  bool generate(Minefield &field, int width, int height, int bombsPer256,
+                int firstX, int firstY, uint64_t seed, size_t maxCandidates = 100000,
+                double maxSeconds = 0) {
+    const auto deadline = chrono::steady_clock::now()
+                          +chrono::duration_cast<chrono::steady_clock::duration>(
+                            chrono::duration<double>(maxSeconds));
+    tried = 0;
+    atomic<bool> found{false};
+    mutex m;
+    uint64_t foundSeed = 0;
+    pool.forEach(pool.size(), [&](size_t, int thread) {
+      mt19937_64 random = threadRandom(seed, thread);
+      Solver solver(1);
+      Minefield candidate;
+      while (!found && (maxSeconds==0 || chrono::steady_clock::now()<deadline)
+             && tried++<maxCandidates) {
+        const uint64_t candidateSeed = random();
+        candidate.initialize(width, height, candidateSeed, bombsPer256);
+        candidate.clearAround(firstX, firstY);
+        if (!playable(candidate, firstX, firstY, solver)) continue;
+        lock_guard<mutex> lock(m);
+        if (!found) foundSeed = candidateSeed;
+        found = true;
+      }
+    });
+    tried = min(size_t(tried), maxCandidates);
+    if (!found) foundSeed = threadRandom(seed, 0)();
+    field.initialize(width, height, foundSeed, bombsPer256);
+    field.clearAround(firstX, firstY);
+    return found;
+  }
+};
+
+#endif
@@ -0,0 +1,49 @@
+// Benchmark of the Generator of fields that can be won without guessing.
+//
+// Generates fields one after the other, with the first click in the
+// middle, and prints for each the number of candidates it took and the
+// time, then the number of fields and of candidates per second.
+//
+// It does not need FLTK.
+//
+// Usage: generatorbench.out [width] [height] [bombs per 256 cells] [fields] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "generator.h"
+#include "minefield.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  const int width = argc>1?atoi(argv[1]): 30;
+  const int height = argc>2?atoi(argv[2]): 16;
+  const int bombsPer256 = argc>3?atoi(argv[3]): 32;
+  const int fields = argc>4?atoi(argv[4]): 20;
+  const int threads = argc>5?atoi(argv[5]): thread::hardware_concurrency();
+
+  Generator generator(threads);
+  Minefield field;
+  int found = 0;
+  size_t totalCandidates = 0;
+  double totalSeconds = 0;
+  for (int seed = 0; seed<fields; seed++) {
+    const auto start = chrono::steady_clock::now();
+    const bool ok = generator.generate(field, width, height, bombsPer256, width/2, height/2, seed);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    found += ok;
+    totalCandidates += generator.candidates();
+    totalSeconds += seconds;
+    cout << fixed << setprecision(2) << "field " << seed << ": "
+         << (ok?"found": "not found") << " after " << generator.candidates()
+         << " candidates in " << seconds*1000 << " ms" << endl;
+  }
+  cout << fixed << setprecision(2) << width << "x" << height << ", " << bombsPer256
+       << " bombs per 256 cells, " << generator.threads() << " threads: "
+       << found/totalSeconds << " fields per second, "
+       << setprecision(0) << totalCandidates/totalSeconds << " candidates per second" << endl;
+  return 0;
+}
@@ -0,0 +1,209 @@
+#ifndef __INFINITEFIELD_H
+#define __INFINITEFIELD_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+/*--------------------------------------------------
+
+InfiniteField class.
+
+A field without edges, for the endless mode. Whether
+a cell has a bomb is not stored: it is a hash of the
+seed and of the position of the cell, so any cell
+can be looked at, anywhere, without making anything.
+The cell 0, 0 and its neighbors never have a bomb,
+so that the game can start there.
+
+Only the cells made visible are stored, one bit per
+cell, in chunks of 64x64 cells made when one of
+their cells is revealed and found again from their
+position in a hash map. At most maxChunks of them
+are in memory: when one more is needed, the one used
+the longest time ago is written to a file, 520 bytes
+per chunk, and read back from it when it is needed
+again. So the memory taken only grows with the part
+of the field that was explored, by a few bytes per
+chunk that is in the file.
+
+A field without a file name, or whose file can not
+be opened, keeps all its chunks in memory.
+
+Positions go up to 2^37 cells away from 0, 0.
+
+--------------------------------------------------*/
+
+class InfiniteField {
+ public:
+  static const int chunkBits = 6;
+  static const int chunkSize = 1 << chunkBits; // Cells on a side of a chunk
+  // makeVisible stops after that many cells, see there
+  static const size_t maxFlood = 1 << 20;
+ private:
+  struct Chunk {
+    uint64_t key;
+    array<uint64_t, chunkSize> visible; // One row of bits per row of cells
+    bool changed; // Since it was last written to the file
+  };
+  uint64_t seed = 0;
+  int bombsPer256 = 32;
+  size_t maxChunks;
+  list<Chunk> chunks; // The chunks in memory, the last used first
+  unordered_map<uint64_t, list<Chunk>::iterator> loaded;
+  unordered_map<uint64_t, uint64_t> written; // Position in the file of the chunks
+  string fileName;
+  fstream file;
+  uint64_t fileSize = 0;
+  size_t revealedCells = 0;
+  bool exploded = false;
+  deque<pair<int64_t, int64_t>> queue; // Of makeVisible
+
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27))*0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+  static uint64_t chunkKey(int64_t x, int64_t y) {
+    return uint64_t(uint32_t(x >> chunkBits)) << 32 | uint32_t(y >> chunkBits);
+  }
+  // The chunk of the cell x, y, nullptr if none of its cells were ever
+  // revealed, unless make is true
+  Chunk *findChunk(int64_t x, int64_t y, bool make) {
+    const uint64_t key = chunkKey(x, y);
+    if (!chunks.empty() && chunks.front().key==key) return &chunks.front();
+    auto found = loaded.find(key);
+    if (found!=loaded.end()) {
+      chunks.splice(chunks.begin(), chunks, found->second);
+      return &chunks.front();
+    }
+    auto inFile = written.find(key);
+    if (inFile==written.end() && !make) return nullptr;
+    if (file.is_open() && chunks.size()>=maxChunks) evict();
+    chunks.push_front({key, {}, inFile==written.end()});
+    loaded[key] = chunks.begin();
+    if (inFile!=written.end()) {
+      file.seekg(inFile->second+sizeof(key));
+      file.read(reinterpret_cast<char *>(chunks.front().visible.data()), sizeof(Chunk::visible));
+    }
+    return &chunks.front();
+  }
+  // Writes the chunk used the longest time ago to the file, if it
+  // changed, and removes it from memory
+  void evict() {
+    Chunk &last = chunks.back();
+    if (last.changed) {
+      auto [position, added] = written.insert({last.key, fileSize});
+      if (added) fileSize += sizeof(last.key)+sizeof(Chunk::visible);
+      file.seekp(position->second);
+      file.write(reinterpret_cast<const char *>(&last.key), sizeof(last.key));
+      file.write(reinterpret_cast<const char *>(last.visible.data()), sizeof(Chunk::visible));
+    }
+    loaded.erase(last.key);
+    chunks.pop_back();
+  }
+ public:
+  InfiniteField(const string &fileName, size_t maxChunks = 4096):
+    maxChunks{max(size_t(1), maxChunks)}, fileName{fileName} {
+    initialize(0);
+  }
+  // A new field, with nothing visible, where every cell has a bomb with
+  // a probability of bombsPer256/256
+  void initialize(uint64_t newSeed, int newBombsPer256 = 32) {
+    seed = newSeed;
+    bombsPer256 = newBombsPer256;
+    chunks.clear();
+    loaded.clear();
+    written.clear();
+    file.close();
+    file.clear();
+    if (!fileName.empty()) file.open(fileName, ios::in | ios::out | ios::binary | ios::trunc);
+    fileSize = 0;
+    revealedCells = 0;
+    exploded = false;
+  }
+  bool isBomb(int64_t x, int64_t y) const {
+    if (x>=-1 && x<=1 && y>=-1 && y<=1) return false;
+    return int(mix(mix(seed ^ uint64_t(x))+uint64_t(y)) & 255)<bombsPer256;
+  }
+  int neighborBombCount(int64_t x, int64_t y) const {
+    int count = 0;
+    for (int dy = -1; dy<=1; dy++)
+      for (int dx = -1; dx<=1; dx++)
+        count += (dx!=0 || dy!=0) && isBomb(x+dx, y+dy);
+    return count;
+  }
+  bool isVisible(int64_t x, int64_t y) {
+    const Chunk *chunk = findChunk(x, y, false);
+    return chunk && (chunk->visible[y & (chunkSize-1)] >> (x & (chunkSize-1)) & 1);
+  }
+
+  // Makes the cell visible and, if there is no bomb around it, all its
+  // neighbors too, and so on, crossing from chunk to chunk. Returns the
+  // number of cells it made visible.
+  //
+  // With few bombs, the cells without bombs around can go on forever,
+  // so it stops after maxFlood cells: the cells at the edge are visible
+  // but not their neighbors. Calling it again on one of them, already
+  // visible, carries on from there.
+  size_t makeVisible(int64_t x, int64_t y) {
+    size_t revealed = 0;
+    if (isVisible(x, y)) {
+      if (neighborBombCount(x, y)>0) return 0;
+    } else {
+      Chunk *chunk = findChunk(x, y, true);
+      chunk->visible[y & (chunkSize-1)] |= uint64_t{1} << (x & (chunkSize-1));
+      chunk->changed = true;
+      revealed = 1;
+      if (isBomb(x, y)) {
+        revealedCells += 1;
+        exploded = true;
+        return 1;
+      }
+    }
+    queue.clear();
+    queue.push_back({x, y});
+    while (!queue.empty() && revealed<maxFlood) {
+      const auto [cx, cy] = queue.front();
+      queue.pop_front();
+      if (neighborBombCount(cx, cy)>0) continue;
+      for (int dy = -1; dy<=1; dy++)
+        for (int dx = -1; dx<=1; dx++) {
+          const int64_t nx = cx+dx, ny = cy+dy;
+          Chunk *chunk = findChunk(nx, ny, true);
+          uint64_t &row = chunk->visible[ny & (chunkSize-1)];
+          const uint64_t bit = uint64_t{1} << (nx & (chunkSize-1));
+          if (row & bit) continue;
+          row |= bit;
+          chunk->changed = true;
+          revealed += 1;
+          queue.push_back({nx, ny});
+        }
+    }
+    revealedCells += revealed;
+    return revealed;
+  }
+
+  bool bombExposed() const {
+    return exploded;
+  }
+  size_t getRevealedCells() const {
+    return revealedCells;
+  }
+  size_t getChunksInMemory() const {
+    return chunks.size();
+  }
+  size_t getChunksInFile() const {
+    return written.size();
+  }
+};
+
+#endif
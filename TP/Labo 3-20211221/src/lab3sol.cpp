@@ -12,6 +12,14 @@
 #include <iostream>
 #include <random>
 #include <array>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+#include "generator.h"
+#include "infinitefield.h"
+#include "minefield.h"
+#include "solver.h"
 
 using namespace std;
 
@@ -156,132 +164,6 @@ bool Rectangle::contains(Point p) {
 }
 
 
-/*--------------------------------------------------
-
-Cell class.
-
-The Canvas class below will have cells as instance
-vraiables and call the methods of Cell
---------------------------------------------------*/
-
-
-class Cell {
-  Rectangle r;
-  bool bomb;
-  bool visible = false;
-  vector<Cell *> neighbors;
-  Text textNeighborBombCount;
-
-  // Private methods
-  int neighborBombCount();
-  void makeVisible(); // Used in the last step to reveal more than one cell
- public:
-  // Constructor
-  Cell(Point center, int w, int h);
-
-  // Methods that draw and handle events
-  void draw();
-  void mouseMove(Point mouseLoc);
-  void mouseClick(Point mouseLoc);
-
-  // Used to initalize neighbors after all cells are created
-  void setNeighbors(const vector<Cell *> newNeighbors) {
-    neighbors = newNeighbors;
-  }
-
-  // Getters used by Canvas to see if the game is won/lost
-  bool isBomb() {
-    return bomb;
-  }
-  bool isVisible() {
-    return visible;
-  }
-
-
-  // Use these instead of draw to see what you should have at the end of task 2/3
-  void drawTaskTwo();
-  void drawTaskThree();
-};
-
-Cell::Cell(Point center, int w, int h):
-  r(center, w, h, FL_BLACK, FL_WHITE),
-  bomb{rand()%8==0},
-  textNeighborBombCount("", center, h/2) {}
-
-void Cell::draw() {
-  if (visible)
-    if (bomb) {
-      r.setFillColor(FL_RED);
-      r.draw();
-    } else {
-      r.setFillColor(FL_WHITE);
-      r.draw();
-      if (neighborBombCount()>0) {
-        textNeighborBombCount.setString(to_string(neighborBombCount()));
-        textNeighborBombCount.draw();
-      }
-    } else {
-    r.setFillColor(fl_rgb_color(200, 150, 167));
-    r.draw();
-  }
-}
-
-// NOTE: Use this instead of draw to see how the game should function at the end of task 2
-void Cell::drawTaskTwo() {
-  if (bomb) {
-    r.setFillColor(FL_RED);
-    r.draw();
-  } else {
-    r.setFillColor(FL_WHITE);
-    r.draw();
-  }
-}
-
-// NOTE: Use this instead of draw to see how the game should function at the end of task 3
-void Cell::drawTaskThree() {
-  if (bomb) {
-    r.setFillColor(FL_RED);
-    r.draw();
-  } else {
-    r.setFillColor(FL_WHITE);
-    r.draw();
-    textNeighborBombCount.setString(to_string(neighborBombCount()));
-    textNeighborBombCount.draw();
-
-  }
-}
-
-void Cell::mouseMove(Point mouseLoc) {
-  if (r.contains(mouseLoc)) {
-    r.setFrameColor(FL_RED);
-  } else {
-    r.setFrameColor(FL_BLACK);
-  }
-}
-
-void Cell::makeVisible() {
-  if (!visible) {
-    visible = true;
-    if (neighborBombCount()==0)
-      for (auto &neighbor: neighbors)
-        neighbor->makeVisible();
-  }
-}
-
-void Cell::mouseClick(Point mouseLoc) {
-  if (r.contains(mouseLoc)) {
-    makeVisible();
-  }
-}
-
-int Cell::neighborBombCount() {
-  int bombCount = 0;
-  for (auto &neighbor: neighbors)
-    if (neighbor->isBomb())
-      bombCount++;
-  return bombCount;
-}
-
 /*--------------------------------------------------
 
 Canvas class.
@@ -299,16 +181,130 @@ keyPressed whenever a key is pressed
 Any drawing code should be called ONLY in draw
 or methods called by draw. If you try to draw
 elsewhere it will probably crash.
+
+The cells are kept in a Minefield, which only holds
+their state. Their rectangle and text are made when
+they are drawn, from their position: at the start,
+the cell x, y is a square of 40 pixels centered at
+50*x+25, 50*y+25.
+
+The window is a view of a part of the field, which
+can be moved with the arrow keys and zoomed with the
+mouse wheel or the + and - keys. Only the cells that
+are at least partly in the view are drawn, so the
+time taken by a frame does not depend on the size of
+the field, and moving the view only changes where it
+starts.
+
+The mouse events go straight to the cell under the
+mouse, found by dividing its position in the field
+by the distance between cells, and the canvas only
+remembers which cell is under the mouse.
+
+The h key shows hints from the Solver: the cells
+that are safe for sure in green, those that have a
+bomb for sure in black, and the probability of a
+bomb in the other hidden cells next to a count.
+
+The bombs are only placed on the first click, by a
+Generator, so that the cell clicked and its
+neighbors have none and, on fields of up to
+maxNoGuessCells cells, the rest can almost always be
+found without guessing. Every game has its own seed, drawn from a
+generator seeded once by the system.
+
+In the endless mode, the field is an InfiniteField,
+which has no edges, and the view can go anywhere.
+The game starts with the cell 0, 0 revealed, in the
+middle of the window, and is only over on a bomb.
+
+A right click puts a flag on a hidden cell, or takes
+it off, and cells with a flag are not revealed. The
+s key saves the game to saveFileName and the l key
+loads it back, which is instant even for a very big
+field, see Minefield::save.
 --------------------------------------------------*/
 
+const int cellPitch = 50; // Pixels from one cell to the next at the start
+const int minCellPitch = 10;
+const int maxCellPitch = 200;
+
+// Size of the field in cells, can be given on the command line
+int fieldColumns = 10;
+int fieldRows = 10;
+// Bigger fields only have a safe first click, making sure they can be
+// won without guessing would take too long. The first click waits for
+// the generator, so it also gives up after noGuessSeconds and keeps a
+// field that is only safe on the first click.
+const int maxNoGuessCells = 2500;
+const double noGuessSeconds = 0.05;
+// Endless mode, see main, and the file of the chunks of its field
+bool endlessMode = false;
+const string endlessFileName = "lab3-endless.chunks";
+const string saveFileName = "lab3.field";
+
+// Division rounded down, also for the negative positions of the endless
+// mode
+int64_t floorDiv(int64_t a, int b) {
+  return a/b-(a%b<0);
+}
 
 class Canvas {
   Text textGameOver{"Game Over", {250, 250}, 90, fl_rgb_color(255, 0, 255)};
   Text textYouWin{"You Win!", {250, 250}, 90, FL_GREEN};
-  vector< vector<Cell> > cells;
-  vector<Cell *> neighbors(int x, int y);
-  int neighborBombCount(int x, int y);
+  Minefield field;
+  InfiniteField plane{endlessMode?endlessFileName: ""}; // Instead of field in endless mode
+  // The view: size of the window, and the position in the field, in
+  // pixels, of its top left corner
+  int viewWidth = windowWidth, viewHeight = windowHeight;
+  int64_t viewX = 0, viewY = 0;
+  int pitch = cellPitch; // Pixels from one cell to the next
+  Point mouse{-1, -1};
+  bool hovered = false; // Is there a cell under the mouse?
+  int64_t hoveredX = 0, hoveredY = 0;
+  Solver solver;
+  Generator generator;
+  mt19937_64 random{random_device{}()};
+  bool started = false; // Are the bombs placed?
+  bool showHints = false;
+  unordered_map<int64_t, double> hints; // Bomb probability of the frontier cells
   void initialize();
+  void updateHints();
+  int cellSize() const {
+    return pitch*4/5;
+  }
+  Rectangle cellRectangle(int64_t x, int64_t y) const {
+    return Rectangle({int(pitch*x+pitch/2-viewX), int(pitch*y+pitch/2-viewY)},
+                     cellSize(), cellSize());
+  }
+  // The cell under p, false if p is in the gap between cells or outside
+  // of the field
+  bool cellAt(Point p, int64_t &x, int64_t &y) const {
+    const int gap = (pitch-cellSize())/2;
+    if (p.x<0 || p.y<0) return false;
+    const int64_t fieldX = p.x+viewX, fieldY = p.y+viewY;
+    x = floorDiv(fieldX, pitch);
+    y = floorDiv(fieldY, pitch);
+    if (fieldX-x*pitch<gap || fieldX-x*pitch>=gap+cellSize()
+        || fieldY-y*pitch<gap || fieldY-y*pitch>=gap+cellSize())
+      return false;
+    return endlessMode || field.contains(x, y);
+  }
+  // The cell x, y of field, or of plane in endless mode
+  bool isVisible(int64_t x, int64_t y) {
+    return endlessMode?plane.isVisible(x, y): field.isVisible(x, y);
+  }
+  bool isBomb(int64_t x, int64_t y) const {
+    return endlessMode?plane.isBomb(x, y): field.isBomb(x, y);
+  }
+  int neighborBombCount(int64_t x, int64_t y) const {
+    return endlessMode?plane.neighborBombCount(x, y): field.neighborBombCount(x, y);
+  }
+  void drawCell(int64_t x, int64_t y);
+  void moveView(int dx, int dy);
+  void save();
+  void load();
+  void zoom(Point center, int newPitch);
  public:
   Canvas() {
     initialize();
@@ -316,101 +312,190 @@ class Canvas {
   bool bombExposed();
   bool solved();
   void draw();
+  void resize(int width, int height);
   void mouseMove(Point mouseLoc);
   void mouseClick(Point mouseLoc);
+  void mouseRightClick(Point mouseLoc);
+  void mouseWheel(Point mouseLoc, int dy);
   void keyPressed(int keyCode);
 };
 
 void Canvas::initialize() {
   // This is called by the constructor but also by keyPressed to
   // reset whenver spacebar is called.
+  if (endlessMode) {
+    plane.initialize(random());
+    plane.makeVisible(0, 0);
+    viewX = pitch/2-viewWidth/2;
+    viewY = pitch/2-viewHeight/2;
+  } else
+    field.initialize(fieldColumns, fieldRows, random());
+  started = false;
+  updateHints();
+}
 
-  // Until the last step when we needed to reset, this would be the constructor
-
-  cells.clear(); // Needed to remove the cells if we are starting again
-
-  for (int x = 0; x<10; x++) {
-    cells.push_back({});
-    for (int y = 0; y<10; y++)
-      cells[x].push_back({{50*x+25, 50*y+25}, 40, 40});
-  }
-
-  // This computes the (pointers to) neighbors of each cell
-  for (int x = 0; x<10; x++)
-    for (int y = 0; y<10; y++) {
-      vector<Cell *> neighbors;
-      for (auto &shift: vector<Point>({
-      {-1, 0}, // The 8 neighbors relative to the cell
-      {-1, 1},
-      { 0, 1},
-      { 1, 1},
-      { 1, 0},
-      { 1, -1},
-      { 0, -1},
-      {-1, -1},
-    })) {
-        int neighborx = x+shift.x;
-        int neighbory = y+shift.y;
-        if (neighborx >= 0 && // Check if the indicies are in range
-            neighbory >= 0 &&
-            neighborx < cells.size() &
-            neighbory < cells[neighborx].size())
-          neighbors.push_back(&cells[neighborx][neighbory]);
-        cells[x][y].setNeighbors(neighbors);
-      }
-    }
+void Canvas::updateHints() {
+  hints.clear();
+  if (!showHints || endlessMode) return;
+  const Solver::Result result = solver.solve(field);
+  for (const auto &cell: result.frontier)
+    hints[int64_t(cell.y)*fieldColumns+cell.x] = cell.mine;
+  cout << result.frontier.size() << " frontier cells in " << result.components
+       << " components, " << result.safeCells << " safe, " << result.mineCells << " bombs"
+       << (result.exact?"": " (not exact)") << ", solved in "
+       << result.seconds*1000 << " ms" << endl;
 }
 
 bool Canvas::bombExposed() {
   // Is there a cell with a bomb that is exposed?
-  for (auto &v: cells)
-    for (auto &c: v)
-      if (c.isVisible() && c.isBomb() )
-        return true;
-  return false;
+  return endlessMode?plane.bombExposed(): field.bombExposed();
 }
 
 
 bool Canvas::solved() {
-  // Are all cells without bombs visible?
-  for (auto &v: cells)
-    for (auto &c: v) {
-      if (c.isVisible() && c.isBomb() )
-        return false;
-      if (!c.isVisible() && !c.isBomb() )
-        return false;
+  // Are all cells without bombs visible? Never in endless mode
+  return !endlessMode && field.solved();
+}
+
+void Canvas::drawCell(int64_t x, int64_t y) {
+  Rectangle r = cellRectangle(x, y);
+  if (hovered && x==hoveredX && y==hoveredY) r.setFrameColor(FL_RED);
+  if (isVisible(x, y))
+    if (isBomb(x, y)) {
+      r.setFillColor(FL_RED);
+      r.draw();
+    } else {
+      r.setFillColor(FL_WHITE);
+      r.draw();
+      // The numbers are not readable in cells that are too small
+      if (neighborBombCount(x, y)>0 && cellSize()>=16)
+        Text(to_string(neighborBombCount(x, y)), r.getCenter(), cellSize()/2).draw();
+    } else {
+    auto hint = hints.find(int64_t(y)*fieldColumns+x);
+    if (!endlessMode && field.isFlagged(x, y)) {
+      r.setFillColor(FL_BLUE);
+      r.draw();
+    } else if (hint==hints.end()) {
+      r.setFillColor(fl_rgb_color(200, 150, 167));
+      r.draw();
+    } else if (hint->second==0) {
+      r.setFillColor(FL_GREEN);
+      r.draw();
+    } else if (hint->second==1) {
+      r.setFillColor(FL_BLACK);
+      r.draw();
+    } else {
+      r.setFillColor(fl_rgb_color(200, 150, 167));
+      r.draw();
+      if (cellSize()>=32)
+        Text(to_string(int(hint->second*100+0.5))+"%", r.getCenter(), cellSize()/3).draw();
     }
-  return true;
+  }
 }
 
 void Canvas::draw() {
-  for (auto &v: cells)
-    for (auto &c: v) {
-// Replace draw here if you want to see what it should look like after task 2/3
-//            c.drawTaskTwo();
-//            c.drawTaskThree();
-      c.draw();
-    }
+  // Only the cells that are at least partly in the view
+  const int64_t firstX = floorDiv(viewX, pitch), firstY = floorDiv(viewY, pitch);
+  int64_t lastX = floorDiv(viewX+viewWidth-1, pitch), lastY = floorDiv(viewY+viewHeight-1, pitch);
+  if (!endlessMode) {
+    lastX = min<int64_t>(lastX, fieldColumns-1);
+    lastY = min<int64_t>(lastY, fieldRows-1);
+  }
+  for (int64_t x = firstX; x<=lastX; x++)
+    for (int64_t y = firstY; y<=lastY; y++)
+      drawCell(x, y);
   // We need to check to see if we need to draw game over or you win
+  textGameOver.setCenter({viewWidth/2, viewHeight/2});
+  textYouWin.setCenter({viewWidth/2, viewHeight/2});
   if (bombExposed())
     textGameOver.draw();
   if (solved()) {
     textYouWin.draw();
   }
 }
+
+void Canvas::resize(int width, int height) {
+  viewWidth = width;
+  viewHeight = height;
+  moveView(0, 0);
+}
+
+// Moves the view by dx, dy pixels, without going past the edges of the
+// field if it has some
+void Canvas::moveView(int dx, int dy) {
+  viewX += dx;
+  viewY += dy;
+  if (!endlessMode) {
+    viewX = max<int64_t>(0, min<int64_t>(viewX, int64_t(fieldColumns)*pitch-viewWidth));
+    viewY = max<int64_t>(0, min<int64_t>(viewY, int64_t(fieldRows)*pitch-viewHeight));
+  }
+  mouseMove(mouse); // Another cell may now be under the mouse
+}
+
+// Changes the size of the cells, keeping the point of the field under
+// center where it is in the window
+void Canvas::zoom(Point center, int newPitch) {
+  newPitch = max(minCellPitch, min(newPitch, maxCellPitch));
+  const double fieldX = double(viewX+center.x)/pitch, fieldY = double(viewY+center.y)/pitch;
+  pitch = newPitch;
+  viewX = int64_t(fieldX*pitch)-center.x;
+  viewY = int64_t(fieldY*pitch)-center.y;
+  moveView(0, 0);
+}
+
 void Canvas::mouseMove(Point mouseLoc) {
-  for (auto &v: cells)
-    for (auto &c: v)
-      c.mouseMove(mouseLoc);
+  mouse = mouseLoc;
+  hovered = cellAt(mouseLoc, hoveredX, hoveredY);
 }
 
 void Canvas::mouseClick(Point mouseLoc) {
   // We only respond to mouse clicks if the game is not over/won
-  if (!bombExposed() && !solved()) {
-    for (auto &v: cells)
-      for (auto &c: v)
-        for (auto &c: v) c.mouseClick(mouseLoc);
+  int64_t x, y;
+  if (!bombExposed() && !solved() && cellAt(mouseLoc, x, y)) {
+    if (endlessMode) {
+      plane.makeVisible(x, y);
+      return;
+    }
+    if (!started) {
+      if (fieldColumns*int64_t(fieldRows)<=maxNoGuessCells)
+        generator.generate(field, fieldColumns, fieldRows, 32, x, y, random(), 1000, noGuessSeconds);
+      else
+        field.clearAround(x, y);
+      started = true;
+    }
+    field.makeVisible(x, y);
+    updateHints();
+  }
+}
+
+void Canvas::mouseRightClick(Point mouseLoc) {
+  // Flags are only on the field, and not before the bombs are placed
+  int64_t x, y;
+  if (!endlessMode && started && !bombExposed() && !solved() && cellAt(mouseLoc, x, y))
+    field.toggleFlag(x, y);
+}
+
+void Canvas::save() {
+  if (endlessMode) return;
+  if (!field.save(saveFileName)) cout << "Could not save the game to " << saveFileName << endl;
+}
+
+void Canvas::load() {
+  if (endlessMode) return;
+  if (!field.load(saveFileName)) {
+    cout << "Could not load a game from " << saveFileName << endl;
+    return;
   }
+  fieldColumns = field.getWidth();
+  fieldRows = field.getHeight();
+  started = true;
+  moveView(0, 0);
+  updateHints();
+}
+
+void Canvas::mouseWheel(Point mouseLoc, int dy) {
+  // Up zooms in, down zooms out
+  zoom(mouseLoc, dy<0?pitch*5/4+1: pitch*4/5);
 }
 
 void Canvas::keyPressed(int keyCode) {
@@ -418,6 +503,37 @@ void Canvas::keyPressed(int keyCode) {
     case ' ':
       initialize();
       break;
+    case FL_Left:
+      moveView(-viewWidth/4, 0);
+      break;
+    case FL_Right:
+      moveView(viewWidth/4, 0);
+      break;
+    case FL_Up:
+      moveView(0, -viewHeight/4);
+      break;
+    case FL_Down:
+      moveView(0, viewHeight/4);
+      break;
+    case '+':
+    case '=':
+    case FL_KP+'+':
+      zoom({viewWidth/2, viewHeight/2}, pitch*5/4+1);
+      break;
+    case '-':
+    case FL_KP+'-':
+      zoom({viewWidth/2, viewHeight/2}, pitch*4/5);
+      break;
+    case 'h':
+      showHints = !showHints;
+      updateHints();
+      break;
+    case 's':
+      save();
+      break;
+    case 'l':
+      load();
+      break;
     case 'q':
       exit(0);
   }
@@ -428,7 +544,10 @@ void Canvas::keyPressed(int keyCode) {
 
 MainWindow class.
 
-Do not edit!!!!
+Passes the moves and clicks of the mouse, its wheel,
+the keys and the changes of size of the window to
+the Canvas, and redraws it refreshPerSecond times a
+second.
 
 --------------------------------------------------*/
 
@@ -443,13 +562,23 @@ class MainWindow : public Fl_Window {
     Fl_Window::draw();
     canvas.draw();
   }
+  void resize(int x, int y, int w, int h) override {
+    Fl_Window::resize(x, y, w, h);
+    canvas.resize(w, h);
+  }
   int handle(int event) override {
     switch (event) {
       case FL_MOVE:
         canvas.mouseMove(Point{Fl::event_x(), Fl::event_y()});
         return 1;
       case FL_PUSH:
-        canvas.mouseClick(Point{Fl::event_x(), Fl::event_y()});
+        if (Fl::event_button()==FL_RIGHT_MOUSE)
+          canvas.mouseRightClick(Point{Fl::event_x(), Fl::event_y()});
+        else
+          canvas.mouseClick(Point{Fl::event_x(), Fl::event_y()});
+        return 1;
+      case FL_MOUSEWHEEL:
+        canvas.mouseWheel(Point{Fl::event_x(), Fl::event_y()}, Fl::event_dy());
         return 1;
       case FL_KEYDOWN:
         canvas.keyPressed(Fl::event_key());
@@ -469,13 +598,22 @@ class MainWindow : public Fl_Window {
 
 main
 
-Do not edit!!!!
+Takes the size of the field, or the endless mode,
+from the command line, before FLTK sees it.
 
 --------------------------------------------------*/
 
 
+// lab3sol.out [columns rows | endless]
 int main(int argc, char *argv[]) {
-  srand(time(0));
+  if (argc>1 && string(argv[1])=="endless") {
+    endlessMode = true;
+    argc = 1;
+  } else if (argc>2) {
+    fieldColumns = max(1, atoi(argv[1]));
+    fieldRows = max(1, atoi(argv[2]));
+    argc = 1; // The size is not for FLTK
+  }
   MainWindow window;
   window.show(argc, argv);
   return Fl::run();
@@ -0,0 +1,355 @@
+#ifndef __MINEFIELD_H
+#define __MINEFIELD_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*--------------------------------------------------
+
+Minefield class.
+
+The state of every cell of the game in one byte:
+
+  bits 0-3: number of bombs in the 8 neighbors
+  bit 4:    the cell has a bomb
+  bit 5:    the cell is visible
+  bit 6:    the cell is outside of the field
+  bit 7:    the cell has a flag
+
+all the bytes in one block, one row after the
+other. There is one more row above and below the
+field, and one more column on each side, made of
+cells outside of the field. So the 8 neighbors of
+any cell of the field are always in the block, at
+index-stride-1 up to index+stride+1, and loops over
+them do not have to check that they are in range.
+
+A field of 10 million cells takes 10 MB and is made
+in a few tens of milliseconds.
+
+save writes a small header then these bytes as they
+are, so that load only has to map the file in memory
+and use them in place: it reads nothing but the
+header, and the system loads the pages of the cells
+the first time they are looked at. The mapping is
+private, changes to the field are not written back
+to the file.
+
+--------------------------------------------------*/
+
+class Minefield {
+ public:
+  static const uint8_t countMask = 0x0F;
+  static const uint8_t Bomb = 0x10;
+  static const uint8_t Visible = 0x20;
+  static const uint8_t Outside = 0x40;
+  static const uint8_t Flag = 0x80;
+ private:
+  // The start of a saved field, followed by the cells
+  struct Header {
+    char magic[4] = {'M', 'F', 'L', 'D'};
+    int32_t width, height, bombsPer256;
+    uint64_t seed, safeCells, revealedSafeCells;
+    uint64_t exploded;
+  };
+  int width = 0, height = 0;
+  int bombsPer256 = 32;
+  uint64_t seed = 0;
+  int stride = 2; // Bytes from one row to the next
+  uint8_t *cells = nullptr; // In storage, or in the mapped file
+  vector<uint8_t> storage;
+  void *mapped = nullptr;
+  size_t mappedSize = 0;
+  // Kept up to date by makeVisible, so that the state of the game is
+  // known without looking at the cells
+  size_t safeCells = 0;
+  size_t revealedSafeCells = 0;
+  bool exploded = false;
+  vector<size_t> queue; // Ring buffer of makeVisible, its size a power of 2
+
+  size_t cellCount() const {
+    return size_t(stride)*(height+2);
+  }
+  void unmap() {
+    if (mapped) munmap(mapped, mappedSize);
+    mapped = nullptr;
+    mappedSize = 0;
+  }
+  size_t index(int x, int y) const {
+    return size_t(y+1)*stride+x+1;
+  }
+  // The 8 neighbors of a cell are at its index plus these
+  array<ptrdiff_t, 8> neighborOffsets() const {
+    return {-stride-1, -stride, -stride+1, -1, 1, stride-1, stride, stride+1};
+  }
+  // Makes room for one more cell at the end of the ring buffer of
+  // makeVisible, which holds count cells from head
+  void growQueue(size_t &head, size_t count) {
+    if (count<queue.size()) return;
+    vector<size_t> bigger(2*queue.size());
+    for (size_t i = 0; i<count; i++)
+      bigger[i] = queue[(head+i) & (queue.size()-1)];
+    queue.swap(bigger);
+    head = 0;
+  }
+ public:
+  Minefield(int width = 0, int height = 0, uint64_t seed = 0, int bombsPer256 = 32) {
+    initialize(width, height, seed, bombsPer256);
+  }
+  // A copy has its own cells, even if those of other are in a file
+  Minefield(const Minefield &other) {
+    *this = other;
+  }
+  Minefield &operator=(const Minefield &other) {
+    if (this==&other) return *this;
+    unmap();
+    width = other.width;
+    height = other.height;
+    bombsPer256 = other.bombsPer256;
+    seed = other.seed;
+    stride = other.stride;
+    storage.assign(other.cells, other.cells+other.cellCount());
+    cells = storage.data();
+    safeCells = other.safeCells;
+    revealedSafeCells = other.revealedSafeCells;
+    exploded = other.exploded;
+    return *this;
+  }
+  ~Minefield() {
+    unmap();
+  }
+  // A new field where every cell has a bomb with a probability of
+  // bombsPer256/256, 1/8 by default
+  void initialize(int newWidth, int newHeight, uint64_t newSeed, int newBombsPer256 = 32) {
+    width = newWidth;
+    height = newHeight;
+    bombsPer256 = newBombsPer256;
+    seed = newSeed;
+    stride = width+2;
+    unmap();
+    storage.assign(cellCount(), Outside);
+    cells = storage.data();
+    safeCells = size_t(width)*height;
+    revealedSafeCells = 0;
+    exploded = false;
+
+    // Eight random bits per cell
+    mt19937_64 random(seed);
+    for (int y = 0; y<height; y++) {
+      uint8_t *row = &cells[index(0, y)];
+      for (int x = 0; x<width; x += 8) {
+        uint64_t bits = random();
+        for (int i = x; i<x+8 && i<width; i++, bits >>= 8) {
+          const bool bomb = int(bits & 255)<bombsPer256;
+          row[i] = bomb?Bomb: 0;
+          safeCells -= bomb;
+        }
+      }
+    }
+
+    // The count of a cell is the sum of the bombs of the 3 cells around
+    // it in the row above, its own row and the row below, less its own
+    // bomb. The sums of 3 cells of each row are computed once, in a
+    // buffer for the previous, current and next row.
+    vector<uint8_t> sums(3*size_t(stride), 0);
+    auto rowSums = [&](int y, uint8_t *sum) {
+      const uint8_t *row = &cells[size_t(y+1)*stride];
+      for (int i = 1; i<=width; i++)
+        sum[i] = ((row[i-1] & Bomb)+(row[i] & Bomb)+(row[i+1] & Bomb))/Bomb;
+    };
+    uint8_t *above = &sums[0], *current = &sums[stride], *below = &sums[2*size_t(stride)];
+    if (height>0) rowSums(0, current);
+    for (int y = 0; y<height; y++) {
+      if (y+1<height) rowSums(y+1, below);
+      else fill(below, below+stride, 0);
+      uint8_t *row = &cells[index(0, y)-1];
+      for (int i = 1; i<=width; i++)
+        row[i] |= above[i]+current[i]+below[i]-((row[i] & Bomb)!=0);
+      uint8_t *oldAbove = above;
+      above = current;
+      current = below;
+      below = oldAbove;
+    }
+  }
+  // Removes the bombs of the cell and of its 8 neighbors, so that
+  // revealing it first is safe and floods around it. Only for a field
+  // where nothing is visible yet.
+  void clearAround(int x, int y) {
+    const auto offsets = neighborOffsets();
+    const size_t center = index(x, y);
+    for (ptrdiff_t around: {ptrdiff_t{0}, offsets[0], offsets[1], offsets[2], offsets[3],
+                            offsets[4], offsets[5], offsets[6], offsets[7]}) {
+      const size_t i = center+around;
+      if ((cells[i] & (Bomb | Outside))!=Bomb) continue;
+      cells[i] &= ~Bomb;
+      safeCells += 1;
+      for (ptrdiff_t offset: offsets)
+        if (!(cells[i+offset] & Outside)) cells[i+offset] -= 1;
+    }
+  }
+  int getWidth() const {
+    return width;
+  }
+  int getHeight() const {
+    return height;
+  }
+  // The seed given to initialize
+  uint64_t getSeed() const {
+    return seed;
+  }
+  // Probability that a cell has a bomb, before anything is known about it
+  double getBombDensity() const {
+    return bombsPer256/256.0;
+  }
+  bool contains(int x, int y) const {
+    return x>=0 && x<width && y>=0 && y<height;
+  }
+  bool isBomb(int x, int y) const {
+    return cells[index(x, y)] & Bomb;
+  }
+  bool isVisible(int x, int y) const {
+    return cells[index(x, y)] & Visible;
+  }
+  int neighborBombCount(int x, int y) const {
+    return cells[index(x, y)] & countMask;
+  }
+  bool isFlagged(int x, int y) const {
+    return cells[index(x, y)] & Flag;
+  }
+  // Puts a flag on a hidden cell, or removes it
+  void toggleFlag(int x, int y) {
+    if (!(cells[index(x, y)] & Visible)) cells[index(x, y)] ^= Flag;
+  }
+
+  // Makes the cell visible and, if there is no bomb around it, all its
+  // neighbors too, and so on, but not the cells with a flag. Returns
+  // the number of cells it made visible.
+  //
+  // The cells are visited in breadth-first order from a queue, and made
+  // visible when they are put in it, so each cell goes through the
+  // queue once and the time taken only depends on the number of cells
+  // made visible. The queue is a ring buffer kept from one call to the
+  // next: it only holds the edge of the region being revealed, and only
+  // grows, by doubling, if that edge is longer than ever before.
+  size_t makeVisible(int x, int y) {
+    size_t i = index(x, y);
+    if (cells[i] & (Visible | Outside | Flag)) return 0;
+    cells[i] |= Visible;
+    if (cells[i] & Bomb) {
+      exploded = true;
+      return 1;
+    }
+    if (queue.empty()) queue.resize(1024);
+    const auto offsets = neighborOffsets();
+    size_t revealed = 1, head = 0, count = 0;
+    for (;;) {
+      if ((cells[i] & countMask)==0)
+        for (ptrdiff_t offset: offsets) {
+          uint8_t &neighbor = cells[i+offset];
+          if (neighbor & (Visible | Outside | Flag)) continue;
+          neighbor |= Visible;
+          revealed += 1;
+          growQueue(head, count);
+          queue[(head+count++) & (queue.size()-1)] = i+offset;
+        }
+      if (count==0) {
+        // Only cells with no bomb around have their neighbors revealed,
+        // so none of the cells revealed has a bomb
+        revealedSafeCells += revealed;
+        return revealed;
+      }
+      i = queue[head];
+      head = (head+1) & (queue.size()-1);
+      count -= 1;
+    }
+  }
+
+  // Is there a cell with a bomb that is exposed?
+  bool bombExposed() const {
+    return exploded;
+  }
+  // Are all cells without bombs visible, and none with?
+  bool solved() const {
+    return !exploded && revealedSafeCells==safeCells;
+  }
+  size_t getSafeCells() const {
+    return safeCells;
+  }
+  size_t getRevealedSafeCells() const {
+    return revealedSafeCells;
+  }
+
+  // Writes the field to the file, returns false if it could not. The
+  // file is written under another name then renamed, so that a field
+  // mapped from it keeps its cells.
+  bool save(const string &fileName) const {
+    const string temporary = fileName+".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    Header header;
+    header.width = width;
+    header.height = height;
+    header.bombsPer256 = bombsPer256;
+    header.seed = seed;
+    header.safeCells = safeCells;
+    header.revealedSafeCells = revealedSafeCells;
+    header.exploded = exploded;
+    bool ok = fwrite(&header, sizeof(header), 1, file)==1
+              && fwrite(cells, 1, cellCount(), file)==cellCount();
+    ok = fclose(file)==0 && ok;
+    if (ok) ok = rename(temporary.c_str(), fileName.c_str())==0;
+    if (!ok) remove(temporary.c_str());
+    return ok;
+  }
+  // Maps a field written by save, returns false and leaves the field as
+  // it was if the file can not be read or is not a saved field
+  bool load(const string &fileName) {
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd<0) return false;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info)==0 && size_t(info.st_size)>=sizeof(Header))
+      data = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid
+    if (data==MAP_FAILED) return false;
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, Header().magic, sizeof(header.magic))!=0
+        || header.width<0 || header.height<0
+        || size_t(info.st_size)!=sizeof(Header)+(size_t(header.width)+2)*(size_t(header.height)+2)) {
+      munmap(data, info.st_size);
+      return false;
+    }
+    unmap();
+    storage.clear();
+    storage.shrink_to_fit();
+    mapped = data;
+    mappedSize = info.st_size;
+    width = header.width;
+    height = header.height;
+    bombsPer256 = header.bombsPer256;
+    seed = header.seed;
+    stride = width+2;
+    cells = static_cast<uint8_t *>(data)+sizeof(Header);
+    safeCells = header.safeCells;
+    revealedSafeCells = header.revealedSafeCells;
+    exploded = header.exploded;
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,90 @@
+// Micro-benchmark of the neighbor bomb counts of lab3sol.cpp.
+//
+// Compares, on a field of 1000x1000 cells with a bomb in one cell out
+// of 8, the work done for the counts in one frame where every cell is
+// visible:
+//
+//   - walking the neighbors list of every cell twice, as Cell::draw
+//     used to do through neighborBombCount
+//   - reading the count stored as a byte per cell, computed once when
+//     the field is made
+//
+// It does not need FLTK, only the counts are timed.
+//
+// Usage: neighborbench.out [size] [frames]
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// The part of Cell that the count looks at
+struct ListCell {
+  bool bomb;
+  vector<ListCell *> neighbors;
+  int neighborBombCount() const {
+    int bombCount = 0;
+    for (auto &neighbor: neighbors)
+      if (neighbor->bomb)
+        bombCount++;
+    return bombCount;
+  }
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char *argv[]) {
+  const int size = argc>1?atoi(argv[1]): 1000;
+  const int frames = argc>2?atoi(argv[2]): 20;
+  srand(1);
+
+  vector<vector<ListCell>> cells(size, vector<ListCell>(size));
+  for (auto &column: cells)
+    for (auto &c: column) c.bomb = rand()%8==0;
+  for (int x = 0; x<size; x++)
+    for (int y = 0; y<size; y++)
+      for (int dx = -1; dx<=1; dx++)
+        for (int dy = -1; dy<=1; dy++)
+          if ((dx!=0 || dy!=0) && x+dx>=0 && x+dx<size && y+dy>=0 && y+dy<size)
+            cells[x][y].neighbors.push_back(&cells[x+dx][y+dy]);
+
+  // The sums are printed so that the compiler can not skip the loops
+  long long listSum = 0;
+  auto start = chrono::steady_clock::now();
+  for (int frame = 0; frame<frames; frame++)
+    for (auto &column: cells)
+      for (auto &c: column)
+        if (!c.bomb && c.neighborBombCount()>0)
+          listSum += c.neighborBombCount();
+  const double listSeconds = secondsSince(start)/frames;
+
+  start = chrono::steady_clock::now();
+  vector<uint8_t> counts(size_t(size)*size);
+  for (int x = 0; x<size; x++)
+    for (int y = 0; y<size; y++)
+      counts[size_t(x)*size+y] = cells[x][y].neighborBombCount();
+  const double initializeSeconds = secondsSince(start);
+
+  long long cachedSum = 0;
+  start = chrono::steady_clock::now();
+  for (int frame = 0; frame<frames; frame++)
+    for (int x = 0; x<size; x++)
+      for (int y = 0; y<size; y++)
+        if (!cells[x][y].bomb && counts[size_t(x)*size+y]>0)
+          cachedSum += counts[size_t(x)*size+y];
+  const double cachedSeconds = secondsSince(start)/frames;
+
+  cout << fixed << setprecision(3)
+       << size << "x" << size << " cells, " << frames << " frames" << endl
+       << "neighbors list: " << listSeconds*1000 << " ms per frame" << endl
+       << "cached byte:    " << cachedSeconds*1000 << " ms per frame, "
+       << initializeSeconds*1000 << " ms once to compute the counts" << endl
+       << setprecision(1) << "speedup " << listSeconds/cachedSeconds << "x"
+       << (listSum==cachedSum?"": " (the counts differ!)") << endl;
+  return listSum==cachedSum?0: 1;
+}
@@ -0,0 +1,68 @@
+// Benchmark of Minefield::save and Minefield::load.
+//
+// Makes a field of 10000x10000 cells, reveals an empty cell near the
+// middle and flags a few cells, saves it, loads it back and prints the
+// time both took, then checks that the loaded field is the same as the
+// saved one, which also times reading all of its cells the first time.
+//
+// It does not need FLTK.
+//
+// Usage: snapshotbench.out [size] [file]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "minefield.h"
+
+using namespace std;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char *argv[]) {
+  const int size = argc>1?atoi(argv[1]): 10000;
+  const string fileName = argc>2?argv[2]: "snapshotbench.field";
+
+  Minefield field(size, size, 1, 8);
+  int x = size/2, y = size/2;
+  while (x<size && (field.isBomb(x, y) || field.neighborBombCount(x, y)>0)) x++;
+  if (x<size) field.makeVisible(x, y);
+  for (int i = 0; i<size; i += 7)
+    field.toggleFlag(i, i);
+
+  auto start = chrono::steady_clock::now();
+  if (!field.save(fileName)) {
+    cout << "Could not save to " << fileName << endl;
+    return 1;
+  }
+  const double saveSeconds = secondsSince(start);
+
+  start = chrono::steady_clock::now();
+  Minefield loaded;
+  if (!loaded.load(fileName)) {
+    cout << "Could not load " << fileName << endl;
+    return 1;
+  }
+  const double loadSeconds = secondsSince(start);
+
+  start = chrono::steady_clock::now();
+  size_t differences = 0;
+  for (int cy = 0; cy<size; cy++)
+    for (int cx = 0; cx<size; cx++)
+      differences += field.isBomb(cx, cy)!=loaded.isBomb(cx, cy)
+                     || field.isVisible(cx, cy)!=loaded.isVisible(cx, cy)
+                     || field.isFlagged(cx, cy)!=loaded.isFlagged(cx, cy)
+                     || field.neighborBombCount(cx, cy)!=loaded.neighborBombCount(cx, cy);
+  const double compareSeconds = secondsSince(start);
+  remove(fileName.c_str());
+
+  cout << fixed << setprecision(2) << size << "x" << size << " cells, "
+       << loaded.getRevealedSafeCells() << " revealed: saved in " << saveSeconds*1000
+       << " ms, loaded in " << loadSeconds*1000 << " ms, " << differences
+       << " cells differ, compared in " << compareSeconds*1000 << " ms" << endl;
+  return differences>0 || loaded.getSeed()!=field.getSeed()
+         || loaded.getRevealedSafeCells()!=field.getRevealedSafeCells();
+}
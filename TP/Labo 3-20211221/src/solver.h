@@ -0,0 +1,356 @@
+#ifndef __SOLVER_H
+#define __SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "minefield.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/*--------------------------------------------------
+
+Solver class.
+
+Finds, from what the player can see of a Minefield,
+the probability that each hidden cell has a bomb.
+
+Every visible count next to hidden cells is a
+constraint: so many bombs among these cells. The
+hidden cells next to a count are the frontier, and
+two of them are in the same component when they are
+linked by constraints. Components do not share any
+constraint, so they are solved on their own, in
+parallel on a ThreadPool.
+
+In a component, the solver first applies two rules
+until they find nothing new:
+
+  - single cell: if a count has as many bombs left
+    as hidden cells, they all have a bomb, if it has
+    none left, none of them has one
+  - subset: if the hidden cells of a count A are all
+    around a count B too, the cells of B that are not
+    around A hold the bombs of B less those of A
+
+For the subset rule, the cells of two counts are
+bitsets of the 7x7 square around A, which holds all
+the neighbors of both counts, so comparing them is
+a few operations on a 64-bit integer.
+
+Then it counts all the ways of placing bombs in the
+cells that are left, each weighted by how likely it
+is with the bomb density of the field, to get exact
+probabilities. The cells are taken one after the
+other, and the only thing that matters for the rest
+is how many bombs are still to place around the
+counts that have some of their cells on each side.
+The ways to reach each of these states are added up
+together (memoized counting), once going forward and
+once backward, so the time taken grows with the
+number of states and not of placements.
+
+Hidden cells that are not on the frontier are not
+constrained by anything the player can see, so they
+keep the density of the field as probability.
+
+--------------------------------------------------*/
+
+class Solver {
+ public:
+  struct CellProbability {
+    int x, y;
+    double mine;  // Probability that the cell has a bomb
+  };
+  struct Result {
+    vector<CellProbability> frontier;  // Hidden cells next to a visible count
+    double otherCells = 0;  // Probability of a bomb in the other hidden cells
+    int safeCells = 0;      // Frontier cells that have no bomb for sure
+    int mineCells = 0;      // Frontier cells that have a bomb for sure
+    int components = 0;     // Independent parts of the frontier
+    bool exact = true;      // False if a component had too many states to count
+    double seconds = 0;
+  };
+ private:
+  struct Constraint {
+    int x, y;           // The visible cell
+    int count;          // Bombs around it that are not visible
+    vector<int> cells;  // Its hidden neighbors, as frontier indices
+  };
+  struct Component {
+    vector<int> cells;  // Frontier indices, neighbors next to each other
+    vector<int> constraints;
+  };
+  ThreadPool pool;
+  size_t maxStates;
+  double density = 0;
+  // Filled by solve before the components are solved
+  vector<CellProbability> frontier;
+  vector<Constraint> constraints;
+  vector<vector<int>> cellConstraints;  // Constraints of every frontier cell
+  vector<int> position;  // Index of every frontier cell in its component
+  atomic<bool> exact{true};
+
+  // Bit of the cell x, y in a 7x7 square centered on the cell cx, cy
+  static uint64_t squareBit(int x, int y, int cx, int cy) {
+    return uint64_t{1} << ((y-cy+3)*7+x-cx+3);
+  }
+  // The cells of c that are not known yet, in the square around cx, cy
+  uint64_t unknownBits(const Constraint &c, int cx, int cy, const vector<int8_t> &value) const {
+    uint64_t bits = 0;
+    for (int cell: c.cells)
+      if (value[position[cell]]<0)
+        bits |= squareBit(frontier[cell].x, frontier[cell].y, cx, cy);
+    return bits;
+  }
+  int bombsLeft(const Constraint &c, const vector<int8_t> &value) const {
+    int left = c.count;
+    for (int cell: c.cells) left -= value[position[cell]]==1;
+    return left;
+  }
+  // Sets the cells of c whose bit is in bits to bomb, returns true if
+  // there was any
+  bool setCells(const Constraint &c, uint64_t bits, int cx, int cy, int8_t bomb,
+                vector<int8_t> &value) const {
+    bool changed = false;
+    for (int cell: c.cells)
+      if ((bits & squareBit(frontier[cell].x, frontier[cell].y, cx, cy))
+          && value[position[cell]]<0) {
+        value[position[cell]] = bomb;
+        changed = true;
+      }
+    return changed;
+  }
+
+  // Single cell and subset rules. value is -1 for the cells still
+  // unknown, 0 or 1 for the others.
+  void propagate(const Component &component, vector<int8_t> &value) const {
+    // Pairs of constraints that share a cell
+    vector<pair<int, int>> pairs;
+    for (int cell: component.cells)
+      for (int a: cellConstraints[cell])
+        for (int b: cellConstraints[cell])
+          if (a<b) pairs.push_back({a, b});
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int i: component.constraints) {
+        const Constraint &c = constraints[i];
+        const uint64_t unknown = unknownBits(c, c.x, c.y, value);
+        const int left = bombsLeft(c, value);
+        if (unknown && (left==0 || left==__builtin_popcountll(unknown)))
+          changed |= setCells(c, unknown, c.x, c.y, left>0, value);
+      }
+      for (auto [i, j]: pairs)
+        for (int swapped = 0; swapped<2; swapped++) {
+          const Constraint &a = constraints[swapped?j: i];
+          const Constraint &b = constraints[swapped?i: j];
+          const uint64_t inA = unknownBits(a, a.x, a.y, value);
+          const uint64_t inB = unknownBits(b, a.x, a.y, value);
+          if (!inA || (inA & ~inB)) continue; // Not a subset
+          const uint64_t rest = inB & ~inA;
+          const int left = bombsLeft(b, value)-bombsLeft(a, value);
+          if (rest && (left==0 || left==__builtin_popcountll(rest)))
+            changed |= setCells(b, rest, a.x, a.y, left>0, value);
+        }
+    }
+  }
+
+  // Exact probabilities of the cells of the component, given the
+  // values already known. Returns false if there are too many states.
+  bool count(const Component &component, const vector<int8_t> &value,
+             vector<double> &probability) const {
+    const int n = component.cells.size();
+    const int m = component.constraints.size();
+    // Constraints numbered from 0 in the component, with the positions
+    // of their first and last cells
+    vector<int> first(m, n), last(m, -1), required(m);
+    vector<vector<int>> constraintsOf(n);
+    for (int i = 0; i<m; i++) {
+      const Constraint &c = constraints[component.constraints[i]];
+      required[i] = c.count;
+      for (int cell: c.cells) {
+        first[i] = min(first[i], position[cell]);
+        last[i] = max(last[i], position[cell]);
+        constraintsOf[position[cell]].push_back(i);
+      }
+    }
+    // Cells of constraint i after position k
+    auto cellsAfter = [&](int i, int k) {
+      int after = 0;
+      for (int cell: constraints[component.constraints[i]].cells)
+        after += position[cell]>k;
+      return after;
+    };
+    // The state between cells k-1 and k is the number of bombs left
+    // for every constraint that has cells on both sides, in order
+    vector<vector<int>> active(n+1);
+    for (int i = 0; i<m; i++)
+      for (int k = first[i]+1; k<=last[i]; k++) active[k].push_back(i);
+
+    vector<int> left(m);
+    // The state after cell k has value v, if that is possible
+    auto next = [&](const string &state, int k, int v, string &result) {
+      for (size_t s = 0; s<active[k].size(); s++) left[active[k][s]] = state[s];
+      for (int i: constraintsOf[k]) {
+        if (first[i]==k) left[i] = required[i];
+        left[i] -= v;
+        if (left[i]<0 || left[i]>cellsAfter(i, k)) return false;
+      }
+      result.clear();
+      for (int i: active[k+1]) result += char(left[i]);
+      return true;
+    };
+    auto weight = [&](int k, int v) {
+      if (value[k]>=0) return value[k]==v?1.0: 0.0;
+      return v==1?density: 1-density;
+    };
+
+    vector<unordered_map<string, double>> forward(n+1);
+    forward[0][""] = 1;
+    string t;
+    for (int k = 0; k<n; k++) {
+      for (auto &[state, w]: forward[k])
+        for (int v = 0; v<2; v++)
+          if (weight(k, v)>0 && next(state, k, v, t))
+            forward[k+1][t] += w*weight(k, v);
+      if (forward[k+1].size()>maxStates) return false;
+      // Scaled so that the numbers stay in the range of a double
+      double sum = 0;
+      for (auto &entry: forward[k+1]) sum += entry.second;
+      for (auto &entry: forward[k+1]) entry.second /= sum;
+    }
+
+    unordered_map<string, double> backward, after;
+    after[""] = 1;
+    for (int k = n-1; k>=0; k--) {
+      double bomb = 0, total = 0, largest = 0;
+      backward.clear();
+      for (auto &[state, w]: forward[k]) {
+        double ways = 0;
+        for (int v = 0; v<2; v++)
+          if (weight(k, v)>0 && next(state, k, v, t)) {
+            auto found = after.find(t);
+            if (found==after.end()) continue;
+            const double x = weight(k, v)*found->second;
+            ways += x;
+            if (v==1) bomb += w*x;
+          }
+        total += w*ways;
+        if (ways>0) backward[state] = ways;
+        largest = max(largest, ways);
+      }
+      probability[k] = total>0?bomb/total: density;
+      for (auto &entry: backward) entry.second /= largest;
+      swap(backward, after);
+    }
+    return true;
+  }
+
+  void solveComponent(const Component &component) {
+    const int n = component.cells.size();
+    vector<int8_t> value(n, -1);
+    propagate(component, value);
+    vector<double> probability(n);
+    if (!count(component, value, probability)) {
+      exact = false;
+      for (int k = 0; k<n; k++) probability[k] = value[k]>=0?value[k]: density;
+    }
+    for (int k = 0; k<n; k++) frontier[component.cells[k]].mine = probability[k];
+  }
+ public:
+  Solver(int threads = thread::hardware_concurrency(), size_t maxStates = 1 << 20):
+    pool(threads), maxStates{maxStates} {}
+  Result solve(const Minefield &field) {
+    const auto start = chrono::steady_clock::now();
+    density = field.getBombDensity();
+    frontier.clear();
+    constraints.clear();
+    cellConstraints.clear();
+    exact = true;
+
+    // The constraints, from the visible counts next to hidden cells
+    unordered_map<int64_t, int> frontierIndex;
+    for (int y = 0; y<field.getHeight(); y++)
+      for (int x = 0; x<field.getWidth(); x++) {
+        if (!field.isVisible(x, y) || field.isBomb(x, y)) continue;
+        Constraint c{x, y, field.neighborBombCount(x, y), {}};
+        for (int dy = -1; dy<=1; dy++)
+          for (int dx = -1; dx<=1; dx++) {
+            const int nx = x+dx, ny = y+dy;
+            if ((dx==0 && dy==0) || !field.contains(nx, ny)) continue;
+            if (field.isVisible(nx, ny)) {
+              c.count -= field.isBomb(nx, ny); // An exploded bomb
+              continue;
+            }
+            auto [found, added] = frontierIndex.insert({int64_t(ny)*field.getWidth()+nx,
+                                                        int(frontier.size())});
+            if (added) {
+              frontier.push_back({nx, ny, density});
+              cellConstraints.push_back({});
+            }
+            c.cells.push_back(found->second);
+          }
+        if (c.cells.empty()) continue;
+        for (int cell: c.cells) cellConstraints[cell].push_back(constraints.size());
+        constraints.push_back(move(c));
+      }
+
+    // The components, found by a breadth-first walk from cell to cell
+    // through their constraints, which also keeps the cells of a
+    // constraint close to each other in the component
+    vector<Component> components;
+    position.assign(frontier.size(), -1);
+    vector<bool> constraintSeen(constraints.size());
+    for (size_t start = 0; start<frontier.size(); start++) {
+      if (position[start]>=0) continue;
+      Component component;
+      position[start] = 0;
+      component.cells.push_back(start);
+      for (size_t k = 0; k<component.cells.size(); k++)
+        for (int i: cellConstraints[component.cells[k]]) {
+          if (constraintSeen[i]) continue;
+          constraintSeen[i] = true;
+          component.constraints.push_back(i);
+          for (int cell: constraints[i].cells)
+            if (position[cell]<0) {
+              position[cell] = component.cells.size();
+              component.cells.push_back(cell);
+            }
+        }
+      components.push_back(move(component));
+    }
+    // The biggest first, so that no thread is left with a big one at
+    // the end
+    sort(components.begin(), components.end(), [](const Component &a, const Component &b) {
+      return a.cells.size()>b.cells.size();
+    });
+    pool.forEach(components.size(), [&](size_t i, int) {
+      solveComponent(components[i]);
+    });
+
+    Result result;
+    result.otherCells = density;
+    result.components = components.size();
+    result.exact = exact;
+    for (const CellProbability &cell: frontier) {
+      result.safeCells += cell.mine==0;
+      result.mineCells += cell.mine==1;
+    }
+    result.frontier = move(frontier);
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    return result;
+  }
+};
+
+#endif
@@ -0,0 +1,85 @@
+// Benchmark of the minesweeper Solver.
+//
+// Plays whole games with the Solver: the first click is on a cell
+// without bombs around it, then every cell the Solver finds safe is
+// revealed, and when there is none the hidden cell least likely to have
+// a bomb is. Prints, for every board, whether it was won, the number of
+// times the Solver ran and its total time, then the win rate and the
+// average solve time per board.
+//
+// It does not need FLTK.
+//
+// Usage: solverbench.out [size] [boards] [bombs per 256 cells] [threads]
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "minefield.h"
+#include "solver.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  const int size = argc>1?atoi(argv[1]): 100;
+  const int boards = argc>2?atoi(argv[2]): 20;
+  const int bombsPer256 = argc>3?atoi(argv[3]): 32;
+  const int threads = argc>4?atoi(argv[4]): thread::hardware_concurrency();
+
+  Solver solver(threads);
+  Minefield field;
+  int won = 0;
+  double totalSeconds = 0;
+  for (int board = 0; board<boards; board++) {
+    field.initialize(size, size, board, bombsPer256);
+    // The first cell without bombs around, from the middle
+    int x = size/2, y = size/2;
+    while (y<size && (field.isBomb(x, y) || field.neighborBombCount(x, y)>0))
+      if (++x==size) x = 0, y++;
+    if (y==size) continue;
+    field.makeVisible(x, y);
+
+    int solves = 0, guesses = 0;
+    double seconds = 0;
+    while (!field.bombExposed() && !field.solved()) {
+      const Solver::Result result = solver.solve(field);
+      solves += 1;
+      seconds += result.seconds;
+      if (result.safeCells>0) {
+        for (const auto &cell: result.frontier)
+          if (cell.mine==0) field.makeVisible(cell.x, cell.y);
+        continue;
+      }
+      // A guess: the safest frontier cell, or any other hidden cell if
+      // they are safer
+      guesses += 1;
+      const Solver::CellProbability *best = nullptr;
+      for (const auto &cell: result.frontier)
+        if (!best || cell.mine<best->mine) best = &cell;
+      if (best && best->mine<=result.otherCells) {
+        field.makeVisible(best->x, best->y);
+        continue;
+      }
+      vector<bool> onFrontier(size_t(size)*size);
+      for (const auto &cell: result.frontier) onFrontier[size_t(cell.y)*size+cell.x] = true;
+      bool guessed = false;
+      for (int gy = 0; gy<size && !guessed; gy++)
+        for (int gx = 0; gx<size && !guessed; gx++)
+          if (!field.isVisible(gx, gy) && !onFrontier[size_t(gy)*size+gx]) {
+            field.makeVisible(gx, gy);
+            guessed = true;
+          }
+      if (!guessed && best) field.makeVisible(best->x, best->y);
+    }
+    won += field.solved();
+    totalSeconds += seconds;
+    cout << fixed << setprecision(2) << "board " << board << ": "
+         << (field.solved()?"won": "lost") << ", " << solves << " solves, "
+         << guesses << " guesses, " << seconds*1000 << " ms" << endl;
+  }
+  cout << fixed << setprecision(1) << size << "x" << size << ", " << threads << " threads: won "
+       << won << " of " << boards << " (" << 100.0*won/max(1, boards) << "%), "
+       << setprecision(2) << totalSeconds*1000/max(1, boards) << " ms of solving per board" << endl;
+  return 0;
+}
@@ -0,0 +1,113 @@
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*--------------------------------------------------
+
+ThreadPool class.
+
+A fixed number of threads started once, which run
+the tasks given to forEach. With a single thread the
+tasks are run by the caller and no thread is made.
+
+For example:
+
+  ThreadPool pool(4);
+  pool.forEach(100, [&](size_t i, int thread) {...});
+
+calls the function once for every i from 0 to 99,
+on 4 threads, and returns when all of them are
+done. thread tells which of the threads runs the
+call, from 0 to 3, so that every thread can have its
+own data.
+
+--------------------------------------------------*/
+
+class ThreadPool {
+  vector<thread> threads;
+  mutex m;
+  condition_variable wake, done;
+  // The current job, see forEach
+  function<void(size_t, int)> task;
+  size_t tasks = 0;
+  atomic<size_t> next{0};
+  int running = 0;
+  unsigned job = 0;
+  bool stopping = false;
+
+  void work(int id) {
+    for (size_t i = next++; i<tasks; i = next++) task(i, id);
+  }
+  void loop(int id) {
+    unsigned lastJob = 0;
+    for (;;) {
+      {
+        unique_lock<mutex> lock(m);
+        wake.wait(lock, [&] {
+          return stopping || job!=lastJob;
+        });
+        if (stopping) return;
+        lastJob = job;
+      }
+      work(id);
+      {
+        lock_guard<mutex> lock(m);
+        running -= 1;
+      }
+      done.notify_one();
+    }
+  }
+ public:
+  ThreadPool(int size = thread::hardware_concurrency()) {
+    for (int id = 1; id<max(1, size); id++)
+      threads.emplace_back([this, id] {
+        loop(id);
+      });
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> lock(m);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t: threads) t.join();
+  }
+  int size() const {
+    return threads.size()+1;
+  }
+  // Calls f(i, thread) for every i from 0 to count-1, the caller being
+  // thread 0, and returns when all the calls are over
+  void forEach(size_t count, function<void(size_t, int)> f) {
+    if (threads.empty() || count<=1) {
+      for (size_t i = 0; i<count; i++) f(i, 0);
+      return;
+    }
+    {
+      lock_guard<mutex> lock(m);
+      task = move(f);
+      tasks = count;
+      next = 0;
+      running = threads.size();
+      job += 1;
+    }
+    wake.notify_all();
+    work(0);
+    unique_lock<mutex> lock(m);
+    done.wait(lock, [&] {
+      return running==0;
+    });
+  }
+};
+
+#endif